@@ -0,0 +1,506 @@
+#include "bench.h"
+#include "bench_baseline.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "weather_handler.h"
+#include "display_manager.h"
+#include "display_assets.h"
+#include "config_manager.h"
+#include "json_writer.h"
+#include "json_arena.h"
+#include "heap_monitor.h"
+#include "history_log.h"
+#include "cJSON.h"
+#if CONFIG_PM_ENABLE && !CONFIG_IDF_TARGET_LINUX
+#include "esp_pm.h"
+#endif
+
+static const char *TAG = "BENCH";
+
+#ifndef CONFIG_BENCH_MIN_TIME_MS
+#define CONFIG_BENCH_MIN_TIME_MS 200
+#endif
+#ifndef CONFIG_BENCH_TOLERANCE_PCT
+#define CONFIG_BENCH_TOLERANCE_PCT 20
+#endif
+
+/* Upper bound on one batch, so a case that got much faster cannot run forever */
+#define BENCH_MAX_ITERS (1u << 20)
+
+/* ----------------- Fixtures ----------------- */
+
+/* Open-Meteo reply for the URL built by weather_data_build_url() */
+static const char weather_fixture[] =
+    "{\"latitude\":-30.0,\"longitude\":-51.125,\"generationtime_ms\":0.0432,"
+    "\"utc_offset_seconds\":0,\"timezone\":\"GMT\",\"timezone_abbreviation\":\"GMT\","
+    "\"elevation\":11.0,\"current_units\":{\"time\":\"unixtime\",\"interval\":\"seconds\","
+    "\"temperature_2m\":\"\xc2\xb0" "C\",\"relative_humidity_2m\":\"%\",\"is_day\":\"\","
+    "\"precipitation\":\"mm\",\"weather_code\":\"wmo code\"},\"current\":{\"time\":1760781600,"
+    "\"interval\":900,\"temperature_2m\":21.4,\"relative_humidity_2m\":63,\"is_day\":1,"
+    "\"precipitation\":0.00,\"weather_code\":2}}";
+
+/* Same size as the arena used by weather_data_fetch() */
+static uint64_t arena_buf[4096 / sizeof(uint64_t)];
+static json_arena_t arena = JSON_ARENA_STATIC_INIT(arena_buf);
+
+/* Results are written here so the compiler cannot drop the work */
+static volatile uint32_t sink_u32;
+static uint32_t op_index;
+
+/* ----------------- Cases ----------------- */
+
+static void case_url_build(void)
+{
+    char url[256];
+    weather_data_build_url(url, sizeof(url), -30.0133836f, -51.1459955f);
+    sink_u32 += (uint8_t)url[op_index % 64];
+}
+
+static void case_parse_heap(void)
+{
+    weather_data_t w;
+    weather_data_parse(weather_fixture, &w);
+    sink_u32 += w.timestamp;
+}
+
+static void case_parse_arena(void)
+{
+    weather_data_t w;
+    json_arena_bind(&arena);
+    weather_data_parse(weather_fixture, &w);
+    json_arena_bind(NULL);
+    json_arena_reset(&arena);
+    sink_u32 += w.timestamp;
+}
+
+static void case_clear(void)
+{
+    display_clear();
+}
+
+static void case_draw_pixel(void)
+{
+    uint32_t i = op_index;
+    display_draw_pixel(i & 127, (i >> 7) & 31, i & 1);
+}
+
+static void case_draw_char_6x8(void)
+{
+    display_draw_char_6x8((op_index * 6) % 120, 0, (char)('A' + op_index % 26));
+}
+
+static void case_draw_text_6x8(void)
+{
+    display_draw_text_6x8(0, 24, "H:63% Cloudy 21.4C..");
+}
+
+static void case_draw_char_12x16(void)
+{
+    display_draw_char_12x16((op_index * 12) % 108, 0, (char)('0' + op_index % 10));
+}
+
+static void case_draw_text_12x16(void)
+{
+    display_draw_text_12x16(33, 0, "T:21.4C");
+}
+
+static void case_draw_icon_24(void)
+{
+    display_draw_icon(0, 4, 24, 24, icon_cloud);
+}
+
+static void case_refresh(void)
+{
+    display_refresh();
+}
+
+/* Same drawing as render_weather() in main */
+static void case_frame(void)
+{
+    display_clear();
+    display_draw_icon(0, 4, 24, 24, icon_cloud);
+    display_draw_text_12x16(33, 0, "T:21.4C");
+    display_draw_text_6x8(33, 20, "H:63%");
+    display_refresh();
+}
+
+static void case_config_load(void)
+{
+    app_config_t cfg;
+    config_manager_read_stored(&cfg);
+    sink_u32 += (uint32_t)cfg.latitude;
+}
+
+static esp_err_t discard_sink(void *ctx, const char *data, size_t len)
+{
+    *(size_t *)ctx += len;
+    return ESP_OK;
+}
+
+static heap_sample_t heap_samples[HEAP_MONITOR_SAMPLES];
+
+/* Same document as GET /api/heap */
+static void case_json_heap(void)
+{
+    heap_sample_t *samples = heap_samples;
+    char buf[256];
+    size_t written = 0;
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), discard_sink, &written);
+
+    json_writer_object_begin(&w);
+    json_writer_key(&w, "modules");
+    json_writer_object_begin(&w);
+    for (int m = 0; m < HEAP_MODULE_COUNT; m++) {
+        heap_module_stats_t st;
+        heap_monitor_get_module(m, &st);
+        json_writer_key(&w, heap_monitor_module_name(m));
+        json_writer_object_begin(&w);
+        json_writer_kv_uint(&w, "allocs", st.allocs);
+        json_writer_kv_uint(&w, "frees", st.frees);
+        json_writer_kv_uint(&w, "live_bytes", st.live_bytes);
+        json_writer_kv_uint(&w, "peak_bytes", st.peak_bytes);
+        json_writer_kv_uint(&w, "total_bytes", st.total_bytes);
+        json_writer_object_end(&w);
+    }
+    json_writer_object_end(&w);
+
+    json_writer_kv_uint(&w, "sample_period_s", HEAP_MONITOR_SAMPLE_PERIOD_S);
+    json_writer_key(&w, "samples");
+    json_writer_array_begin(&w);
+    size_t n = heap_monitor_get_samples(samples, HEAP_MONITOR_SAMPLES);
+    for (size_t i = 0; i < n; i++) {
+        json_writer_object_begin(&w);
+        json_writer_kv_uint(&w, "t", samples[i].uptime_s);
+        json_writer_kv_uint(&w, "free", samples[i].free_bytes);
+        json_writer_kv_uint(&w, "largest", samples[i].largest_free);
+        json_writer_kv_uint(&w, "min_free", samples[i].min_free);
+        json_writer_object_end(&w);
+    }
+    json_writer_array_end(&w);
+    json_writer_object_end(&w);
+    json_writer_finish(&w);
+    sink_u32 += written;
+}
+
+/* The /api/heap document the way handlers built it before json_writer: cJSON tree, printed copy */
+static void case_json_heap_cjson(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *modules = cJSON_AddObjectToObject(root, "modules");
+    for (int m = 0; m < HEAP_MODULE_COUNT; m++) {
+        heap_module_stats_t st;
+        heap_monitor_get_module(m, &st);
+        cJSON *mod = cJSON_AddObjectToObject(modules, heap_monitor_module_name(m));
+        cJSON_AddNumberToObject(mod, "allocs", st.allocs);
+        cJSON_AddNumberToObject(mod, "frees", st.frees);
+        cJSON_AddNumberToObject(mod, "live_bytes", st.live_bytes);
+        cJSON_AddNumberToObject(mod, "peak_bytes", st.peak_bytes);
+        cJSON_AddNumberToObject(mod, "total_bytes", st.total_bytes);
+    }
+
+    cJSON_AddNumberToObject(root, "sample_period_s", HEAP_MONITOR_SAMPLE_PERIOD_S);
+    cJSON *arr = cJSON_AddArrayToObject(root, "samples");
+    size_t n = heap_monitor_get_samples(heap_samples, HEAP_MONITOR_SAMPLES);
+    for (size_t i = 0; i < n; i++) {
+        cJSON *s = cJSON_CreateObject();
+        cJSON_AddNumberToObject(s, "t", heap_samples[i].uptime_s);
+        cJSON_AddNumberToObject(s, "free", heap_samples[i].free_bytes);
+        cJSON_AddNumberToObject(s, "largest", heap_samples[i].largest_free);
+        cJSON_AddNumberToObject(s, "min_free", heap_samples[i].min_free);
+        cJSON_AddItemToArray(arr, s);
+    }
+
+    char *out = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (out) {
+        sink_u32 += strlen(out);
+        cJSON_free(out);
+    }
+}
+
+/* ----------------- History streaming ----------------- */
+
+#define HISTORY_CHUNK_SIZE 1024
+
+typedef struct {
+    size_t len;
+    size_t sent;
+    char buf[HISTORY_CHUNK_SIZE];
+} history_sink_t;
+
+static history_sink_t history_sink;
+
+static int format_x100(char *out, size_t max_len, int32_t v)
+{
+    uint32_t a = (v < 0) ? (uint32_t)(-v) : (uint32_t)v;
+    return snprintf(out, max_len, "%s%u.%02u", v < 0 ? "-" : "", (unsigned)(a / 100),
+                    (unsigned)(a % 100));
+}
+
+/* Same CSV lines and chunking as GET /api/history, the socket replaced by a counter */
+static bool history_csv_visit(const history_record_t *rec, void *ctx)
+{
+    history_sink_t *st = ctx;
+    char t[12], h[12], p[12];
+    format_x100(t, sizeof(t), rec->temperature_x100);
+    format_x100(h, sizeof(h), rec->humidity_x100);
+    format_x100(p, sizeof(p), rec->precipitation_x100);
+
+    char line[80];
+    int n = snprintf(line, sizeof(line), "%u,%s,%s,%s,%u,%u\n", (unsigned)rec->timestamp, t, h,
+                     p, (unsigned)rec->weather_code,
+                     (rec->flags & HISTORY_FLAG_IS_DAY) ? 1u : 0u);
+    if (st->len + n > sizeof(st->buf)) {
+        st->sent += st->len;
+        st->len = 0;
+    }
+    memcpy(st->buf + st->len, line, n);
+    st->len += n;
+    return true;
+}
+
+/* The whole log, as /api/history without from/to; see the record count in the report */
+static void case_history_stream(void)
+{
+    history_sink.len = 0;
+    history_sink.sent = 0;
+    size_t n = history_log_query(0, UINT32_MAX, history_csv_visit, &history_sink);
+    sink_u32 += n + history_sink.sent + history_sink.len;
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+    json_arena_t *arena;  ///< Arena whose peak is reported, if any
+} bench_case_t;
+
+static const bench_case_t cases[] = {
+    { "url_build", case_url_build, NULL },
+    { "parse_heap", case_parse_heap, NULL },
+    { "parse_arena", case_parse_arena, &arena },
+    { "clear", case_clear, NULL },
+    { "draw_pixel", case_draw_pixel, NULL },
+    { "draw_char_6x8", case_draw_char_6x8, NULL },
+    { "draw_text_6x8", case_draw_text_6x8, NULL },
+    { "draw_char_12x16", case_draw_char_12x16, NULL },
+    { "draw_text_12x16", case_draw_text_12x16, NULL },
+    { "draw_icon_24", case_draw_icon_24, NULL },
+    { "refresh", case_refresh, NULL },
+    { "frame", case_frame, NULL },
+    { "config_load", case_config_load, NULL },
+    { "json_heap", case_json_heap, NULL },
+    { "json_heap_cjson", case_json_heap_cjson, NULL },
+    { "history_stream", case_history_stream, NULL },
+};
+
+/* ----------------- Runner ----------------- */
+
+static const bench_baseline_t baseline[] = { BENCH_BASELINE_ROWS { NULL, 0, 0 } };
+
+typedef struct {
+    uint32_t total;
+    uint32_t allocs;
+    uint32_t live;
+} tracked_t;
+
+static void tracked_totals(tracked_t *t)
+{
+    *t = (tracked_t) { 0 };
+    for (int m = 0; m < HEAP_MODULE_COUNT; m++) {
+        heap_module_stats_t st;
+        heap_monitor_get_module(m, &st);
+        t->total += st.total_bytes;
+        t->allocs += st.allocs;
+        t->live += st.live_bytes;
+    }
+}
+
+static uint64_t time_batch(const bench_case_t *c, uint32_t iters)
+{
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < iters; i++) {
+        op_index = i;
+        c->run();
+    }
+    return (uint64_t)(esp_timer_get_time() - start);
+}
+
+static void run_case(const bench_case_t *c, bench_result_t *r)
+{
+    c->run();  // Warm-up: caches, lazy init
+
+    /* Double the batch until it is long enough to time */
+    uint32_t iters = 1;
+    uint64_t us = time_batch(c, iters);
+    while (us < CONFIG_BENCH_MIN_TIME_MS * 1000ULL && iters < BENCH_MAX_ITERS) {
+        iters *= 2;
+        us = time_batch(c, iters);
+    }
+
+    /* One more op with the allocation counters around it */
+    tracked_t before, after;
+    tracked_totals(&before);
+    c->run();
+    tracked_totals(&after);
+
+    r->iters = iters;
+    r->ns_per_op = (uint32_t)(us * 1000 / iters);
+    r->bytes_per_op = after.total - before.total;
+    r->allocs_per_op = after.allocs - before.allocs;
+    r->live_delta = after.live - before.live;
+}
+
+static const bench_baseline_t *find_baseline(const char *name)
+{
+    for (size_t i = 0; baseline[i].name; i++) {
+        if (strcmp(baseline[i].name, name) == 0)
+            return &baseline[i];
+    }
+    return NULL;
+}
+
+/* Verdict of one result against its reference; NULL reference only checks for leaks */
+static bool check_result(const bench_result_t *r, const bench_baseline_t *b, int tolerance_pct,
+                         const char **verdict)
+{
+    if (r->live_delta != 0) {
+        *verdict = "LEAK";
+        return false;
+    }
+    if (!b) {
+        *verdict = "no baseline";
+        return true;
+    }
+    if ((uint64_t)r->ns_per_op * 100 > (uint64_t)b->ns_per_op * (100 + tolerance_pct)) {
+        *verdict = "SLOWER";
+        return false;
+    }
+    if (r->bytes_per_op > b->bytes_per_op) {
+        *verdict = "MORE ALLOC";
+        return false;
+    }
+    *verdict = "ok";
+    return true;
+}
+
+static void log_result(const bench_case_t *c, const bench_result_t *r, const bench_baseline_t *b,
+                       bool ok, const char *verdict)
+{
+    unsigned arena_peak = c->arena ? (unsigned)c->arena->high_water : 0u;
+    if (ok)
+        ESP_LOGI(TAG, "%-16s %8u %11u %7u %7u %7u  %s", c->name, (unsigned)r->iters,
+                 (unsigned)r->ns_per_op, (unsigned)r->bytes_per_op, (unsigned)r->allocs_per_op,
+                 arena_peak, verdict);
+    else
+        ESP_LOGE(TAG, "%-16s %8u %11u %7u %7u %7u  %s (baseline %u ns, %u B)", c->name,
+                 (unsigned)r->iters, (unsigned)r->ns_per_op, (unsigned)r->bytes_per_op,
+                 (unsigned)r->allocs_per_op, arena_peak, verdict,
+                 b ? (unsigned)b->ns_per_op : 0u, b ? (unsigned)b->bytes_per_op : 0u);
+}
+
+static void log_header(void)
+{
+    ESP_LOGI(TAG, "%-16s %8s %11s %7s %7s %7s  %s", "case", "iters", "ns/op", "B/op", "allocs",
+             "arena", "verdict");
+}
+
+#if CONFIG_PM_ENABLE && !CONFIG_IDF_TARGET_LINUX
+/* Own lock, so the run does not show up as JSON work in the power_manager sections */
+static esp_pm_lock_handle_t cpu_lock = NULL;
+#endif
+
+static void cpu_max_begin(void)
+{
+#if CONFIG_PM_ENABLE && !CONFIG_IDF_TARGET_LINUX
+    if (!cpu_lock && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "bench", &cpu_lock) != ESP_OK)
+        ESP_LOGW(TAG, "No CPU frequency lock, DFS may skew the results");
+    if (cpu_lock)
+        esp_pm_lock_acquire(cpu_lock);
+#endif
+}
+
+static void cpu_max_end(void)
+{
+#if CONFIG_PM_ENABLE && !CONFIG_IDF_TARGET_LINUX
+    if (cpu_lock)
+        esp_pm_lock_release(cpu_lock);
+#endif
+}
+
+esp_err_t bench_run_all(void)
+{
+    const size_t count = sizeof(cases) / sizeof(cases[0]);
+    bench_result_t results[sizeof(cases) / sizeof(cases[0])];
+    int failed = 0;
+
+    history_log_info_t hist;
+    history_log_get_info(&hist);
+    ESP_LOGI(TAG, "%u cases, >= %d ms each, tolerance %d%%, %u history records", (unsigned)count,
+             CONFIG_BENCH_MIN_TIME_MS, CONFIG_BENCH_TOLERANCE_PCT, (unsigned)hist.count);
+    log_header();
+
+    /* Keep the CPU at its maximum frequency so DFS does not skew the numbers */
+    cpu_max_begin();
+    for (size_t i = 0; i < count; i++) {
+        const bench_case_t *c = &cases[i];
+        bench_result_t *r = &results[i];
+        if (c->arena)
+            c->arena->high_water = 0;
+        run_case(c, r);
+
+        const char *verdict;
+        const bench_baseline_t *b = find_baseline(c->name);
+        bool ok = check_result(r, b, CONFIG_BENCH_TOLERANCE_PCT, &verdict);
+        if (!ok)
+            failed++;
+        log_result(c, r, b, ok, verdict);
+    }
+    cpu_max_end();
+
+#if CONFIG_BENCH_PRINT_BASELINE
+    printf("#define BENCH_BASELINE_ROWS \\\n");
+    for (size_t i = 0; i < count; i++)
+        printf("    { \"%s\", %u, %u },%s\n", cases[i].name, (unsigned)results[i].ns_per_op,
+               (unsigned)results[i].bytes_per_op, (i + 1 < count) ? " \\" : "");
+#endif
+
+    if (failed) {
+        ESP_LOGE(TAG, "%d of %u cases regressed", failed, (unsigned)count);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "All cases within baseline");
+    return ESP_OK;
+}
+
+esp_err_t bench_run_case(const char *name, const bench_baseline_t *ref, int tolerance_pct,
+                         bench_result_t *result)
+{
+    const bench_case_t *c = NULL;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (strcmp(cases[i].name, name) == 0)
+            c = &cases[i];
+    }
+    if (!c)
+        return ESP_ERR_NOT_FOUND;
+
+    bench_result_t r;
+    if (c->arena)
+        c->arena->high_water = 0;
+    cpu_max_begin();
+    run_case(c, &r);
+    cpu_max_end();
+
+    const char *verdict;
+    bool ok = check_result(&r, ref, tolerance_pct, &verdict);
+    log_header();
+    log_result(c, &r, ref, ok, verdict);
+    if (result)
+        *result = r;
+    return ok ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,79 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file bench.h
+ * @brief Hot-path microbenchmarks with regression thresholds.
+ *
+ * Each case runs in batches of doubling size until one batch lasts
+ * CONFIG_BENCH_MIN_TIME_MS, then reports ns/op and the bytes allocated per
+ * op through heap_monitor (plus the arena peak for arena-backed parsing).
+ * Results are checked against the table in bench_baseline.h, which has one
+ * set of numbers for the board and one for the linux host build; cases
+ * without a row there are only checked for leaks. bench_run_case() checks a
+ * single case against a reference supplied by the caller.
+ *
+ * The display, config and history cases need display_init(),
+ * config_manager_init() and history_log_init() to have run (history_stream
+ * streams whatever the log holds, the record count is logged). Display cases
+ * draw into the frame buffer and push it to the panel, so the screen must be
+ * redrawn afterwards.
+ */
+
+/** Reference result of one case, a row of bench_baseline.h */
+typedef struct {
+    const char *name;
+    uint32_t ns_per_op;
+    uint32_t bytes_per_op;
+} bench_baseline_t;
+
+/** Measured result of one case */
+typedef struct {
+    uint32_t iters;
+    uint32_t ns_per_op;
+    uint32_t bytes_per_op;  ///< Tracked heap bytes (all heap_monitor modules)
+    uint32_t allocs_per_op; ///< Tracked heap allocations
+    uint32_t live_delta;    ///< Tracked bytes still allocated after the run
+} bench_result_t;
+
+/**
+ * @brief Run every case and log the report.
+ *
+ * @return
+ *  - ESP_OK if every case is within its baseline.
+ *  - ESP_FAIL if at least one case regressed or leaked.
+ */
+esp_err_t bench_run_all(void);
+
+/**
+ * @brief Run one case and check it against the given reference.
+ *
+ * Same measurement and verdict as bench_run_all(), with the reference and
+ * tolerance supplied by the caller instead of bench_baseline.h and
+ * CONFIG_BENCH_TOLERANCE_PCT.
+ *
+ * @param name          Case name, as in the report.
+ * @param ref           Reference to check against, NULL to only check for leaks.
+ * @param tolerance_pct Allowed slowdown over ref->ns_per_op, in percent.
+ * @param[out] result   Measured result, may be NULL.
+ *
+ * @return
+ *  - ESP_OK if the case is within the reference and did not leak.
+ *  - ESP_ERR_NOT_FOUND if there is no case with that name.
+ *  - ESP_FAIL if the case regressed or leaked.
+ */
+esp_err_t bench_run_case(const char *name, const bench_baseline_t *ref, int tolerance_pct,
+                         bench_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // BENCH_H
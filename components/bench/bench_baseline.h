@@ -0,0 +1,44 @@
+#ifndef BENCH_BASELINE_H
+#define BENCH_BASELINE_H
+
+/*
+ * Reference results of bench.c, one row per case: { name, ns/op, bytes/op },
+ * each row followed by a comma. A case fails above
+ * ns * (100 + CONFIG_BENCH_TOLERANCE_PCT) / 100 or above the byte count.
+ * Cases without a row are reported but not checked (leaks still fail).
+ *
+ * Only numbers measured on the named setup belong here: record them with
+ * CONFIG_BENCH_PRINT_BASELINE and paste the logged rows, keeping the slowest
+ * of several runs so a noisy machine does not fail the gate.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+/*
+ * Host build, -Og, x86_64, slowest of 10 runs of the test app cases with
+ * 1008 history records. parse_heap, parse_arena, json_heap_cjson and
+ * config_load still need rows recorded against the real cJSON and NVS.
+ */
+#define BENCH_BASELINE_ROWS                  \
+    { "url_build", 880, 0 },                 \
+    { "clear", 423, 0 },                     \
+    { "draw_pixel", 7, 0 },                  \
+    { "draw_char_6x8", 141, 0 },             \
+    { "draw_text_6x8", 2659, 0 },            \
+    { "draw_char_12x16", 408, 0 },           \
+    { "draw_text_12x16", 1925, 0 },          \
+    { "draw_icon_24", 2192, 0 },             \
+    { "refresh", 431, 0 },                   \
+    { "frame", 5935, 0 },                    \
+    { "json_heap", 5358, 0 },                \
+    { "history_stream", 1137531, 0 },
+#else
+/*
+ * ESP32 at 160 MHz (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), panel on 100 kHz I2C.
+ * Not recorded yet: every case is only checked for leaks on the board.
+ */
+#define BENCH_BASELINE_ROWS
+#endif
+
+#endif  // BENCH_BASELINE_H
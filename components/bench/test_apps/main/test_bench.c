@@ -0,0 +1,69 @@
+/*
+ * Runs bench_run_all() with the same modules up as at boot in the firmware.
+ * The case fails on a leak in any case, or on a regression against the rows
+ * recorded in bench_baseline.h for this target. The other cases feed
+ * bench_run_case() references the measurement must miss, so a regression is
+ * shown to fail the gate.
+ */
+#include <stdint.h>
+#include "unity.h"
+#include "bench.h"
+#include "display_manager.h"
+#include "config_manager.h"
+#include "history_log.h"
+
+/* Records the history_stream case reads: one week at one sample per 10 min */
+#define BENCH_HISTORY_RECORDS 1008
+
+static void fill_history(void)
+{
+    history_log_info_t info;
+    history_log_get_info(&info);
+    uint32_t t = info.newest_ts ? info.newest_ts : 1760781600;
+
+    for (uint32_t i = info.count; i < BENCH_HISTORY_RECORDS; i++) {
+        t += 600;
+        history_record_t rec = {
+            .timestamp = t,
+            .temperature_x100 = (int16_t)(1500 + (i % 100) * 10),
+            .humidity_x100 = (uint16_t)(5000 + (i % 40) * 50),
+            .weather_code = (uint8_t)(i % 4),
+            .flags = (i % 144 < 72) ? HISTORY_FLAG_IS_DAY : 0,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, history_log_append(&rec));
+    }
+}
+
+TEST_CASE("hot paths within baseline and leak-free", "[bench]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, display_init());
+    TEST_ASSERT_EQUAL(ESP_OK, config_manager_init());
+    TEST_ASSERT_EQUAL(ESP_OK, history_log_init());
+    fill_history();
+
+    TEST_ASSERT_EQUAL(ESP_OK, bench_run_all());
+}
+
+TEST_CASE("case twice as slow as its baseline fails", "[bench]")
+{
+    bench_result_t r;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, bench_run_case("no_such_case", NULL, 0, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, bench_run_case("url_build", NULL, 0, &r));
+
+    /* Half the measured time as the baseline: the case now runs at twice its row */
+    const bench_baseline_t halved = { "url_build", r.ns_per_op / 2, r.bytes_per_op };
+    TEST_ASSERT_EQUAL(ESP_FAIL, bench_run_case("url_build", &halved, 0, NULL));
+
+    const bench_baseline_t doubled = { "url_build", r.ns_per_op * 2, r.bytes_per_op };
+    TEST_ASSERT_EQUAL(ESP_OK, bench_run_case("url_build", &doubled, 0, NULL));
+}
+
+TEST_CASE("case allocating more than its baseline fails", "[bench]")
+{
+    bench_result_t r;
+    TEST_ASSERT_EQUAL(ESP_OK, bench_run_case("parse_heap", NULL, 0, &r));
+    TEST_ASSERT_GREATER_THAN(0, r.bytes_per_op);
+
+    const bench_baseline_t fewer = { "parse_heap", UINT32_MAX, r.bytes_per_op - 1 };
+    TEST_ASSERT_EQUAL(ESP_FAIL, bench_run_case("parse_heap", &fewer, 0, NULL));
+}
@@ -0,0 +1,15 @@
+# Runs the benchmark gate of this app on the board and on the linux target
+import pytest
+from pytest_embedded import Dut
+
+
+@pytest.mark.esp32
+@pytest.mark.generic
+def test_bench(dut: Dut) -> None:
+    dut.run_all_single_board_cases(timeout=300)
+
+
+@pytest.mark.linux
+@pytest.mark.host_test
+def test_bench_host(dut: Dut) -> None:
+    dut.run_all_single_board_cases(timeout=300)
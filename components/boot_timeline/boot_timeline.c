@@ -0,0 +1,66 @@
+#include "boot_timeline.h"
+#include <stdbool.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define WATERFALL_WIDTH 32
+
+static const char *TAG = "BOOT";
+
+/* RTC slow memory: readable after start-up without costing DRAM */
+static RTC_DATA_ATTR boot_phase_t phases[BOOT_TIMELINE_MAX_PHASES];
+static RTC_DATA_ATTR volatile uint32_t phase_count;
+
+/* Plain DRAM, so it is false again after every reset or wake-up */
+static bool started = false;
+
+void boot_timeline_mark(const char *phase)
+{
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    if (!started) {
+        phase_count = 0;
+        started = true;
+    }
+    if (phase_count >= BOOT_TIMELINE_MAX_PHASES)
+        return;
+
+    boot_phase_t *p = &phases[phase_count];
+    strlcpy(p->name, phase, sizeof(p->name));
+    p->t_us = now;
+    phase_count++;  // Publish after the entry is complete
+}
+
+void boot_timeline_dump(void)
+{
+    uint32_t n = phase_count;
+    if (n == 0)
+        return;
+
+    uint32_t total = phases[n - 1].t_us;
+    uint32_t prev = 0;
+    ESP_LOGI(TAG, "Boot timeline (%u phases, %u ms)", (unsigned)n, (unsigned)(total / 1000));
+
+    for (uint32_t i = 0; i < n; i++) {
+        const boot_phase_t *p = &phases[i];
+        char bar[WATERFALL_WIDTH + 1];
+        uint32_t from = total ? (uint32_t)((uint64_t)prev * WATERFALL_WIDTH / total) : 0;
+        uint32_t to = total ? (uint32_t)((uint64_t)p->t_us * WATERFALL_WIDTH / total) : 0;
+        for (uint32_t c = 0; c < WATERFALL_WIDTH; c++)
+            bar[c] = (c < from) ? ' ' : (c < to || c == from) ? '#' : '.';
+        bar[WATERFALL_WIDTH] = '\0';
+
+        ESP_LOGI(TAG, "%-*s %7u us %+8d us |%s|", BOOT_TIMELINE_NAME_LEN - 1, p->name,
+                 (unsigned)p->t_us, (int)(p->t_us - prev), bar);
+        prev = p->t_us;
+    }
+}
+
+size_t boot_timeline_get(const boot_phase_t **out)
+{
+    if (out)
+        *out = phases;
+    return started ? phase_count : 0;  // Entries from before this boot are stale
+}
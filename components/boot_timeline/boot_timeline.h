@@ -0,0 +1,61 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file boot_timeline.h
+ * @brief Startup phase probes and boot waterfall.
+ *
+ * Each probe stores esp_timer_get_time() next to a phase name in a static
+ * array placed in RTC memory. The first probe of a boot clears the entries
+ * left by the previous one, so the array always describes the current boot.
+ * Probes are only meant to be called from the startup path (single writer).
+ */
+
+#define BOOT_TIMELINE_MAX_PHASES 16
+#define BOOT_TIMELINE_NAME_LEN 16
+
+/**
+ * @brief One recorded phase.
+ */
+typedef struct {
+    char name[BOOT_TIMELINE_NAME_LEN];  ///< Phase that just completed
+    uint32_t t_us;                      ///< Time since startup when it completed
+} boot_phase_t;
+
+/**
+ * @brief Record the end of a startup phase.
+ *
+ * Cheap enough for the boot path: one timer read and a short copy. Probes past
+ * BOOT_TIMELINE_MAX_PHASES are dropped.
+ *
+ * @param phase Phase name, truncated to BOOT_TIMELINE_NAME_LEN - 1 characters.
+ */
+void boot_timeline_mark(const char *phase);
+
+/**
+ * @brief Log the recorded phases as a waterfall (offset, duration, bar).
+ */
+void boot_timeline_dump(void);
+
+/**
+ * @brief Access the phases recorded during this boot.
+ *
+ * @param[out] phases Set to the first entry; entries are never rewritten
+ *                    during a boot, so the pointer stays valid.
+ *
+ * @return Number of recorded phases.
+ */
+size_t boot_timeline_get(const boot_phase_t **phases);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // BOOT_TIMELINE_H
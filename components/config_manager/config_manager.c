@@ -0,0 +1,383 @@
+#include "config_manager.h"
+#include "nvs_manager.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_rom_crc.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "CONFIG_MANAGER";
+
+/* Used until a location is saved through the portal */
+#define DEFAULT_LATITUDE -30.0133836
+#define DEFAULT_LONGITUDE -51.1459955
+
+/* ----------------- Persistent record -----------------
+ * The whole configuration is one NVS blob:
+ *
+ *   record_header_t | payload (layout given by version) | CRC32
+ *
+ * Two slots are used alternately. A save goes to the slot that does not
+ * hold the newest valid record, so an interrupted or corrupted write is
+ * detected by its CRC and the previous good copy is used instead.
+ */
+#define RECORD_MAGIC 0x31474643  // "CFG1"
+#define RECORD_VERSION 1
+#define RECORD_MAX_PAYLOAD 256
+
+static const char *const slot_keys[2] = { "cfg_a", "cfg_b" };
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;   ///< Payload layout version
+    uint16_t length;    ///< Payload size in bytes
+    uint32_t sequence;  ///< Incremented on each save, the highest valid slot wins
+} record_header_t;
+
+/* Payload layout of version 1. Never change it: add a new version instead. */
+typedef struct __attribute__((packed)) {
+    char wifi_ssid[33];
+    char wifi_pass[65];
+    double latitude;
+    double longitude;
+} payload_v1_t;
+
+#define RECORD_MAX_SIZE (sizeof(record_header_t) + RECORD_MAX_PAYLOAD + sizeof(uint32_t))
+
+_Static_assert(sizeof(payload_v1_t) <= RECORD_MAX_PAYLOAD, "payload_v1_t too large");
+
+/* Migration hooks: decode an older (or the current) payload layout into app_config_t */
+typedef bool (*payload_decode_fn_t)(const uint8_t *payload, size_t len, app_config_t *out);
+
+static bool decode_v1(const uint8_t *payload, size_t len, app_config_t *out)
+{
+    if (len != sizeof(payload_v1_t))
+        return false;
+
+    payload_v1_t p;
+    memcpy(&p, payload, sizeof(p));
+    memcpy(out->wifi_ssid, p.wifi_ssid, sizeof(out->wifi_ssid));
+    memcpy(out->wifi_pass, p.wifi_pass, sizeof(out->wifi_pass));
+    out->wifi_ssid[sizeof(out->wifi_ssid) - 1] = '\0';
+    out->wifi_pass[sizeof(out->wifi_pass) - 1] = '\0';
+    out->latitude = p.latitude;
+    out->longitude = p.longitude;
+    return true;
+}
+
+/* Indexed by record version; add decode_v2 etc. here when the layout changes */
+static const payload_decode_fn_t decoders[] = {
+    [1] = decode_v1,
+};
+
+typedef struct {
+    config_manager_cb_t cb;
+    void *ctx;
+} subscriber_t;
+
+static SemaphoreHandle_t lock = NULL;
+static bool loaded = false;
+static app_config_t cache;
+static subscriber_t subscribers[APP_CONFIG_MAX_SUBSCRIBERS];
+static size_t subscriber_count = 0;
+
+/* Slot state, valid after config_manager_init() */
+static uint32_t current_sequence = 0;
+static int current_slot = -1;
+
+/* Serialize cfg into buf as a current-version record. Returns the record size. */
+static size_t record_encode(const app_config_t *cfg, uint32_t sequence, uint8_t *buf)
+{
+    payload_v1_t p = { 0 };
+    strlcpy(p.wifi_ssid, cfg->wifi_ssid, sizeof(p.wifi_ssid));
+    strlcpy(p.wifi_pass, cfg->wifi_pass, sizeof(p.wifi_pass));
+    p.latitude = cfg->latitude;
+    p.longitude = cfg->longitude;
+
+    record_header_t h = {
+        .magic = RECORD_MAGIC,
+        .version = RECORD_VERSION,
+        .length = sizeof(p),
+        .sequence = sequence,
+    };
+
+    size_t off = 0;
+    memcpy(buf + off, &h, sizeof(h));
+    off += sizeof(h);
+    memcpy(buf + off, &p, sizeof(p));
+    off += sizeof(p);
+    uint32_t crc = esp_rom_crc32_le(0, buf, off);
+    memcpy(buf + off, &crc, sizeof(crc));
+    return off + sizeof(crc);
+}
+
+/* Validate a stored record and decode it (migrating older layouts) */
+static bool record_decode(const uint8_t *buf, size_t len, app_config_t *out, uint32_t *sequence,
+                          uint16_t *version)
+{
+    record_header_t h;
+    if (len < sizeof(h) + sizeof(uint32_t))
+        return false;
+
+    memcpy(&h, buf, sizeof(h));
+    if (h.magic != RECORD_MAGIC || sizeof(h) + h.length + sizeof(uint32_t) != len)
+        return false;
+
+    uint32_t crc;
+    memcpy(&crc, buf + len - sizeof(crc), sizeof(crc));
+    if (crc != esp_rom_crc32_le(0, buf, len - sizeof(crc)))
+        return false;
+
+    if (h.version >= sizeof(decoders) / sizeof(decoders[0]) || !decoders[h.version])
+        return false;
+
+    if (!decoders[h.version](buf + sizeof(h), h.length, out))
+        return false;
+
+    *sequence = h.sequence;
+    *version = h.version;
+    return true;
+}
+
+/* Write cfg into the slot not holding the newest good copy */
+static esp_err_t record_save(const app_config_t *cfg)
+{
+    uint8_t buf[RECORD_MAX_SIZE];
+    uint32_t sequence = current_sequence + 1;
+    int slot = (current_slot == 0) ? 1 : 0;
+    size_t len = record_encode(cfg, sequence, buf);
+
+    nvs_manager_entry_t entry = { slot_keys[slot], NVS_MANAGER_TYPE_BLOB, buf, len };
+    esp_err_t err = nvs_manager_save_batch(&entry, 1);
+    if (err == ESP_OK) {
+        current_sequence = sequence;
+        current_slot = slot;
+    }
+    return err;
+}
+
+/* Version 0: the pre-blob layout with one NVS key per setting */
+static bool migrate_legacy_keys(app_config_t *cfg)
+{
+    nvs_manager_entry_t entries[] = {
+        { "wifi_ssid", NVS_MANAGER_TYPE_STR, cfg->wifi_ssid, sizeof(cfg->wifi_ssid) },
+        { "wifi_pass", NVS_MANAGER_TYPE_STR, cfg->wifi_pass, sizeof(cfg->wifi_pass) },
+        { "latitude", NVS_MANAGER_TYPE_DOUBLE, &cfg->latitude, sizeof(double) },
+        { "longitude", NVS_MANAGER_TYPE_DOUBLE, &cfg->longitude, sizeof(double) },
+    };
+    size_t found = 0;
+    if (nvs_manager_read_batch(entries, sizeof(entries) / sizeof(entries[0]), &found) != ESP_OK ||
+        found == 0)
+        return false;
+
+    ESP_LOGW(TAG, "Migrating %u legacy config keys to record v%d", (unsigned)found,
+             RECORD_VERSION);
+    if (record_save(cfg) == ESP_OK) {
+        static const char *const legacy_keys[] = { "wifi_ssid", "wifi_pass", "latitude",
+                                                   "longitude" };
+        nvs_manager_erase_keys(legacy_keys, sizeof(legacy_keys) / sizeof(legacy_keys[0]));
+    }
+    return true;
+}
+
+typedef struct {
+    int slot;  ///< Slot holding the newest valid record, -1 if none
+    uint32_t sequence;
+    uint16_t version;
+    int corrupted;  ///< Slots present but failing validation
+} slot_scan_t;
+
+/*
+ * Read both slots through one NVS handle and decode the newest valid record
+ * into cfg. A namespace that was never written is not an error: the scan then
+ * reports no slot and nothing corrupted.
+ */
+static esp_err_t read_slots(app_config_t *cfg, slot_scan_t *scan)
+{
+    static uint8_t slot_buf[2][RECORD_MAX_SIZE];
+    nvs_manager_entry_t entries[2] = {
+        { slot_keys[0], NVS_MANAGER_TYPE_BLOB, slot_buf[0], RECORD_MAX_SIZE },
+        { slot_keys[1], NVS_MANAGER_TYPE_BLOB, slot_buf[1], RECORD_MAX_SIZE },
+    };
+
+    *scan = (slot_scan_t) { .slot = -1 };
+    esp_err_t err = nvs_manager_read_batch(entries, 2, NULL);
+    if (err == ESP_ERR_NVS_NOT_FOUND)
+        return ESP_OK;
+    if (err != ESP_OK)
+        return err;
+
+    app_config_t best_cfg = *cfg;
+    for (int i = 0; i < 2; i++) {
+        if (entries[i].len == 0)
+            continue;
+
+        app_config_t candidate = *cfg;
+        uint32_t seq;
+        uint16_t version;
+        if (!record_decode(slot_buf[i], entries[i].len, &candidate, &seq, &version)) {
+            ESP_LOGW(TAG, "Config slot '%s' is corrupted, ignoring it", slot_keys[i]);
+            scan->corrupted++;
+            continue;
+        }
+        if (scan->slot < 0 || seq > scan->sequence) {
+            scan->slot = i;
+            scan->sequence = seq;
+            scan->version = version;
+            best_cfg = candidate;
+        }
+    }
+    *cfg = best_cfg;
+    return ESP_OK;
+}
+
+esp_err_t config_manager_init(void)
+{
+    if (loaded)
+        return ESP_OK;
+
+    if (!lock)
+        lock = xSemaphoreCreateMutex();
+
+    esp_err_t err = nvs_manager_init();
+    if (err != ESP_OK)
+        return err;
+
+    app_config_t cfg = {
+        .latitude = DEFAULT_LATITUDE,
+        .longitude = DEFAULT_LONGITUDE,
+    };
+
+    slot_scan_t scan;
+    err = read_slots(&cfg, &scan);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Config read failed (%s), using defaults", esp_err_to_name(err));
+    } else if (scan.slot >= 0) {
+        current_slot = scan.slot;
+        current_sequence = scan.sequence;
+        ESP_LOGI(TAG, "Config record v%u from slot '%s' (seq %u)%s", scan.version,
+                 slot_keys[scan.slot], (unsigned)scan.sequence,
+                 scan.corrupted ? ", rolled back to previous good copy" : "");
+        if (scan.version != RECORD_VERSION) {
+            /* Older layout decoded fine: rewrite it in the current one */
+            ESP_LOGW(TAG, "Upgrading config record v%u -> v%d", scan.version, RECORD_VERSION);
+            record_save(&cfg);
+        }
+    } else if (scan.corrupted > 0) {
+        ESP_LOGE(TAG, "No valid config record, using defaults");
+    } else if (!migrate_legacy_keys(&cfg)) {
+        ESP_LOGW(TAG, "No stored config, using defaults");
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    cache = cfg;
+    loaded = true;
+    xSemaphoreGive(lock);
+
+    ESP_LOGI(TAG, "Config loaded: SSID='%s' LAT:%f LON:%f", cfg.wifi_ssid, cfg.latitude,
+             cfg.longitude);
+    return ESP_OK;
+}
+
+void config_manager_get(app_config_t *out)
+{
+    if (!out)
+        return;
+
+    if (!loaded)
+        config_manager_init();
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    *out = cache;
+    xSemaphoreGive(lock);
+}
+
+esp_err_t config_manager_read_stored(app_config_t *out)
+{
+    if (!out)
+        return ESP_ERR_INVALID_ARG;
+    if (!loaded)
+        return ESP_ERR_INVALID_STATE;
+
+    app_config_t cfg = {
+        .latitude = DEFAULT_LATITUDE,
+        .longitude = DEFAULT_LONGITUDE,
+    };
+    slot_scan_t scan;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    esp_err_t err = read_slots(&cfg, &scan);
+    xSemaphoreGive(lock);
+
+    *out = cfg;
+    if (err != ESP_OK)
+        return err;
+    return (scan.slot >= 0) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t config_manager_update(const app_config_t *cfg)
+{
+    if (!cfg)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = config_manager_init();
+    if (err != ESP_OK)
+        return err;
+
+    /* Take a private copy with guaranteed null-terminated strings */
+    app_config_t next = *cfg;
+    next.wifi_ssid[sizeof(next.wifi_ssid) - 1] = '\0';
+    next.wifi_pass[sizeof(next.wifi_pass) - 1] = '\0';
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    uint32_t changed = 0;
+    if (strcmp(next.wifi_ssid, cache.wifi_ssid) != 0 ||
+        strcmp(next.wifi_pass, cache.wifi_pass) != 0)
+        changed |= APP_CONFIG_CHANGED_WIFI;
+    if (next.latitude != cache.latitude || next.longitude != cache.longitude)
+        changed |= APP_CONFIG_CHANGED_LOCATION;
+
+    /* One blob, one commit */
+    if (changed) {
+        err = record_save(&next);
+        if (err == ESP_OK)
+            cache = next;
+    }
+
+    /* Snapshot subscribers so callbacks run without holding the lock */
+    subscriber_t subs[APP_CONFIG_MAX_SUBSCRIBERS];
+    size_t sub_count = subscriber_count;
+    memcpy(subs, subscribers, sizeof(subs));
+
+    xSemaphoreGive(lock);
+
+    if (err != ESP_OK || changed == 0)
+        return err;
+
+    ESP_LOGI(TAG, "Config updated (changed mask 0x%02x)", (unsigned)changed);
+    for (size_t i = 0; i < sub_count; i++) {
+        subs[i].cb(&next, changed, subs[i].ctx);
+    }
+    return ESP_OK;
+}
+
+esp_err_t config_manager_subscribe(config_manager_cb_t cb, void *ctx)
+{
+    if (!cb)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = config_manager_init();
+    if (err != ESP_OK)
+        return err;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (subscriber_count >= APP_CONFIG_MAX_SUBSCRIBERS) {
+        xSemaphoreGive(lock);
+        return ESP_ERR_NO_MEM;
+    }
+    subscribers[subscriber_count++] = (subscriber_t) { .cb = cb, .ctx = ctx };
+    xSemaphoreGive(lock);
+    return ESP_OK;
+}
@@ -0,0 +1,130 @@
+#ifndef CONFIG_MANAGER_H
+#define CONFIG_MANAGER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file config_manager.h
+ * @brief Typed, RAM-cached application configuration.
+ *
+ * The configuration is loaded from NVS once and then served from RAM.
+ * Updates are written back in a single NVS commit and pushed to the
+ * registered subscribers, so settings can change at runtime without a
+ * reboot.
+ *
+ * On flash the whole configuration is one versioned, CRC32-protected
+ * record stored in two alternating slots: a corrupted or partial write
+ * falls back to the previous good copy, and older layouts (including the
+ * legacy one-key-per-setting format) are migrated on load.
+ */
+
+/** Buffer sizes, including the terminating null (802.11 limits + 1). */
+#define APP_CONFIG_SSID_LEN 33
+#define APP_CONFIG_PASS_LEN 65
+
+/** Maximum number of change subscribers. */
+#define APP_CONFIG_MAX_SUBSCRIBERS 4
+
+/**
+ * @brief Application settings.
+ */
+typedef struct {
+    char wifi_ssid[APP_CONFIG_SSID_LEN];  ///< Station SSID (empty = not configured)
+    char wifi_pass[APP_CONFIG_PASS_LEN];  ///< Station password
+    double latitude;                      ///< Weather location, decimal degrees
+    double longitude;                     ///< Weather location, decimal degrees
+} app_config_t;
+
+/**
+ * @brief Bit mask of the settings groups that changed in an update.
+ */
+typedef enum {
+    APP_CONFIG_CHANGED_WIFI = 1 << 0,      ///< SSID or password
+    APP_CONFIG_CHANGED_LOCATION = 1 << 1,  ///< Latitude or longitude
+} app_config_changed_t;
+
+/**
+ * @brief Change notification callback.
+ *
+ * Called from the task that performed the update, after the new values
+ * were committed to flash.
+ *
+ * @param cfg      New configuration (valid during the call only).
+ * @param changed  Mask of ::app_config_changed_t flags.
+ * @param ctx      User context given at subscription.
+ */
+typedef void (*config_manager_cb_t)(const app_config_t *cfg, uint32_t changed, void *ctx);
+
+/**
+ * @brief Load the configuration from NVS into RAM.
+ *
+ * Safe to call multiple times; only the first call touches flash. Without
+ * a valid record the built-in defaults are used.
+ *
+ * @return
+ *  - ESP_OK on success.
+ *  - esp_err_t error code if NVS could not be initialized.
+ */
+esp_err_t config_manager_init(void);
+
+/**
+ * @brief Copy the current configuration.
+ *
+ * @param[out] out Structure to fill.
+ */
+void config_manager_get(app_config_t *out);
+
+/**
+ * @brief Read and decode the stored record from NVS, bypassing the RAM cache.
+ *
+ * The cache is left untouched. Meant for diagnostics and the benchmark;
+ * application code uses config_manager_get().
+ *
+ * @param[out] out Structure to fill (defaults when nothing valid is stored).
+ *
+ * @return
+ *  - ESP_OK if a valid record was decoded.
+ *  - ESP_ERR_NOT_FOUND if no slot holds a valid record.
+ *  - ESP_ERR_INVALID_STATE if config_manager_init() has not run.
+ *  - esp_err_t error code if NVS could not be read.
+ *  - ESP_ERR_INVALID_ARG if @p out is NULL.
+ */
+esp_err_t config_manager_read_stored(app_config_t *out);
+
+/**
+ * @brief Store a new configuration.
+ *
+ * The record is rewritten in one NVS commit only if a field differs from
+ * the cached values. Subscribers are notified when something changed.
+ *
+ * @param cfg New configuration.
+ *
+ * @return
+ *  - ESP_OK on success (also when nothing changed).
+ *  - ESP_ERR_INVALID_ARG for a NULL pointer.
+ *  - esp_err_t error code if the flash write failed (cache left unchanged).
+ */
+esp_err_t config_manager_update(const app_config_t *cfg);
+
+/**
+ * @brief Register a change notification callback.
+ *
+ * @param cb   Callback function.
+ * @param ctx  User context passed to the callback.
+ *
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_NO_MEM if all subscriber slots are taken.
+ */
+esp_err_t config_manager_subscribe(config_manager_cb_t cb, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CONFIG_MANAGER_H
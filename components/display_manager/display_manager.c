@@ -1,13 +1,21 @@
 #include "display_manager.h"
 #include "display_assets.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
+#if !CONFIG_IDF_TARGET_LINUX
 #include "driver/i2c_master.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_panel_ssd1306.h"
+#endif
+#include "power_manager.h"
+#include "metrics.h"
+#include "esp_timer.h"
+#include "trace_recorder.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define I2C_HOST 0
 #define I2C_SDA_GPIO 21
@@ -19,8 +27,6 @@
 #define LCD_I2C_ADDR 0x3C
 
 static const char *TAG = "display_manager";
-static i2c_master_bus_handle_t i2c_bus_handle = NULL;
-static esp_lcd_panel_handle_t panel_handle = NULL;
 static uint8_t framebuffer[LCD_H_RES * LCD_V_RES / 8];
 
 // ======================= BASICS ==========================
@@ -119,11 +125,39 @@ void display_draw_text_12x16(int x, int y, const char *text)
     }
 }
 
-// ======================= PUBLIC CONTROL ====================
-esp_err_t display_init(void)
+// ======================= PANEL ====================
+#if CONFIG_IDF_TARGET_LINUX
+/* Host build: no panel. With DISPLAY_ASCII=1 every frame is printed to stdout,
+   two pixel rows per character line. */
+static void panel_setup(void)
 {
-    ESP_LOGI(TAG, "Initializing SSD1306...");
+}
+
+static void panel_flush(void)
+{
+    if (!getenv("DISPLAY_ASCII"))
+        return;
+
+    char line[LCD_H_RES + 3];
+    line[0] = line[LCD_H_RES + 1] = '|';
+    line[LCD_H_RES + 2] = '\0';
+    for (int y = 0; y < LCD_V_RES; y += 2) {
+        for (int x = 0; x < LCD_H_RES; x++) {
+            int idx = (y / 8) * LCD_H_RES + x;
+            bool top = framebuffer[idx] & (1 << (y % 8));
+            bool bottom = framebuffer[idx] & (1 << ((y + 1) % 8));
+            line[x + 1] = top ? (bottom ? '#' : '"') : (bottom ? '.' : ' ');
+        }
+        puts(line);
+    }
+    puts("");
+}
+#else
+static i2c_master_bus_handle_t i2c_bus_handle = NULL;
+static esp_lcd_panel_handle_t panel_handle = NULL;
 
+static void panel_setup(void)
+{
     i2c_master_bus_config_t i2c_config = {
         .clk_source = I2C_CLK_SRC_DEFAULT,
         .i2c_port = I2C_HOST,
@@ -158,6 +192,19 @@ esp_err_t display_init(void)
     ESP_ERROR_CHECK(esp_lcd_panel_init(panel_handle));
     ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel_handle, true, true));
     ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
+}
+
+static void panel_flush(void)
+{
+    esp_lcd_panel_draw_bitmap(panel_handle, 0, 0, LCD_H_RES, LCD_V_RES, framebuffer);
+}
+#endif
+
+// ======================= PUBLIC CONTROL ====================
+esp_err_t display_init(void)
+{
+    ESP_LOGI(TAG, "Initializing SSD1306...");
+    panel_setup();
 
     clear_framebuffer();
     display_refresh();
@@ -165,6 +212,16 @@ esp_err_t display_init(void)
     return ESP_OK;
 }
 
+esp_err_t display_resume(void)
+{
+    /* The panel kept its GDDRAM while the ESP32 slept: no blanking refresh,
+       the caller redraws the retained content right away. */
+    ESP_LOGI(TAG, "Resuming SSD1306...");
+    panel_setup();
+    clear_framebuffer();
+    return ESP_OK;
+}
+
 void display_clear(void)
 {
     clear_framebuffer();
@@ -173,7 +230,13 @@ void display_clear(void)
 
 void display_refresh(void)
 {
-    esp_lcd_panel_draw_bitmap(panel_handle, 0, 0, LCD_H_RES, LCD_V_RES, framebuffer);
+    power_manager_section_begin(POWER_SECTION_I2C);
+    trace_begin("display_i2c");
+    int64_t start = esp_timer_get_time();
+    panel_flush();
+    metrics_observe_us(METRIC_DISPLAY_REFRESH_TIME, (uint32_t)(esp_timer_get_time() - start));
+    trace_end("display_i2c");
+    power_manager_section_end(POWER_SECTION_I2C);
 }
 
 void display_show_wifi_connecting(void)
@@ -27,6 +27,16 @@ extern "C" {
  */
 esp_err_t display_init(void);
 
+/**
+ * @brief Re-initialize the display after a deep sleep wake-up.
+ *
+ * Same as display_init() but does not blank the screen, so the content
+ * shown before sleep stays visible until the next display_refresh().
+ *
+ * @return ESP_OK on success, otherwise an error code.
+ */
+esp_err_t display_resume(void);
+
 /**
  * @brief Clear the display buffer (does not immediately update the screen).
  */
@@ -2,6 +2,7 @@
 #include "esp_log.h"
 #include "esp_vfs.h"
 #include "esp_littlefs.h"
+#include "heap_monitor.h"
 #include <stdio.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
@@ -73,7 +74,7 @@ esp_err_t fs_handler_read_file(const char *path, char **out_buf, size_t *out_len
     size_t len = ftell(f);
     fseek(f, 0, SEEK_SET);
 
-    char *buf = malloc(len + 1);
+    char *buf = heap_monitor_malloc(HEAP_MODULE_FS, len + 1);
     if (!buf) {
         fclose(f);
         return ESP_ERR_NO_MEM;
@@ -92,6 +93,43 @@ esp_err_t fs_handler_read_file(const char *path, char **out_buf, size_t *out_len
     return ESP_OK;
 }
 
+/* =======================================================================
+ * Chunked read
+ * ======================================================================= */
+FILE *fs_handler_open(const char *path, size_t *out_size)
+{
+    if (!fs_mounted)
+        return NULL;
+
+    char full_path[128];
+    snprintf(full_path, sizeof(full_path), "/littlefs/%s", path);
+
+    FILE *f = fopen(full_path, "rb");
+    if (!f) {
+        ESP_LOGW(TAG, "File not found: %s", full_path);
+        return NULL;
+    }
+
+    if (out_size) {
+        struct stat st;
+        *out_size = (fstat(fileno(f), &st) == 0) ? (size_t)st.st_size : 0;
+    }
+    return f;
+}
+
+size_t fs_handler_read_chunk(FILE *f, char *buf, size_t len)
+{
+    if (!f || !buf)
+        return 0;
+    return fread(buf, 1, len, f);
+}
+
+void fs_handler_close(FILE *f)
+{
+    if (f)
+        fclose(f);
+}
+
 /* =======================================================================
  * Write a file
  * ======================================================================= */
@@ -152,6 +190,37 @@ bool fs_handler_exists(const char *path)
     return (stat(full_path, &st) == 0);
 }
 
+/* =======================================================================
+ * Iterate over files in root
+ * ======================================================================= */
+void fs_handler_for_each_file(fs_handler_file_cb_t cb, void *ctx)
+{
+    if (!fs_mounted || !cb)
+        return;
+
+    DIR *dir = opendir("/littlefs");
+    if (!dir) {
+        ESP_LOGE(TAG, "Error when open folder");
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char full_path[128];
+        snprintf(full_path, sizeof(full_path), "/littlefs/%s", entry->d_name);
+
+        struct stat st;
+        if (stat(full_path, &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "/%s", entry->d_name);
+        cb(path, (size_t)st.st_size, ctx);
+    }
+
+    closedir(dir);
+}
+
 /* =======================================================================
  * List all files in root
  * ======================================================================= */
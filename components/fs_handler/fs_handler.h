@@ -4,6 +4,7 @@
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,7 +31,8 @@ esp_err_t fs_handler_init(void);
 /**
  * @brief Read an entire file into a dynamically allocated buffer.
  *
- * The caller becomes responsible for freeing the returned buffer via `free()`.
+ * The caller becomes responsible for freeing the returned buffer with
+ * `heap_monitor_free(HEAP_MODULE_FS, buf)`.
  *
  * @param path File path inside LittleFS (e.g., "/index.html").
  * @param[out] out_buf Pointer to receive dynamically allocated buffer with file data.
@@ -40,6 +42,38 @@ esp_err_t fs_handler_init(void);
  */
 esp_err_t fs_handler_read_file(const char *path, char **out_buf, size_t *out_len);
 
+/**
+ * @brief Open a file for chunked reading.
+ *
+ * Unlike fs_handler_read_file() nothing is allocated for the contents, so
+ * large files can be streamed with a fixed-size buffer.
+ *
+ * @param path File path inside LittleFS (e.g., "/index.html").
+ * @param[out] out_size Optional pointer to receive the file size in bytes.
+ *
+ * @return Open file handle, or NULL if the file does not exist.
+ *         Close it with fs_handler_close().
+ */
+FILE *fs_handler_open(const char *path, size_t *out_size);
+
+/**
+ * @brief Read the next chunk of a file opened with fs_handler_open().
+ *
+ * @param f File handle.
+ * @param buf Destination buffer.
+ * @param len Buffer size in bytes.
+ *
+ * @return Bytes read, 0 at end of file.
+ */
+size_t fs_handler_read_chunk(FILE *f, char *buf, size_t len);
+
+/**
+ * @brief Close a file opened with fs_handler_open().
+ *
+ * @param f File handle (NULL is ignored).
+ */
+void fs_handler_close(FILE *f);
+
 /**
  * @brief Write a buffer into a file, replacing its contents if it exists.
  *
@@ -67,6 +101,23 @@ esp_err_t fs_handler_delete_file(const char *path);
  */
 bool fs_handler_exists(const char *path);
 
+/**
+ * @brief Callback for fs_handler_for_each_file().
+ *
+ * @param path File path inside LittleFS (e.g., "/index.html").
+ * @param size File size in bytes.
+ * @param ctx  User context.
+ */
+typedef void (*fs_handler_file_cb_t)(const char *path, size_t size, void *ctx);
+
+/**
+ * @brief Call a function for every regular file in the filesystem root.
+ *
+ * @param cb  Callback.
+ * @param ctx User context passed to the callback.
+ */
+void fs_handler_for_each_file(fs_handler_file_cb_t cb, void *ctx);
+
 /**
  * @brief List all files located in the filesystem root.
  *
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""Stage the web assets for the LittleFS image.
+
+Copies every file from the source folder into the staging folder and, for
+text assets, writes a gzip-compressed copy next to it (index.html ->
+index.html.gz). The HTTP server sends the .gz variant to clients that accept
+gzip. Output is reproducible: the gzip header carries no name or mtime.
+"""
+
+import gzip
+import os
+import shutil
+import sys
+
+COMPRESSIBLE = ('.html', '.css', '.js', '.json', '.svg', '.txt')
+
+
+def stage(src_dir, dst_dir):
+    if os.path.isdir(dst_dir):
+        shutil.rmtree(dst_dir)
+    os.makedirs(dst_dir)
+
+    for root, _, files in os.walk(src_dir):
+        rel = os.path.relpath(root, src_dir)
+        out_root = os.path.join(dst_dir, rel) if rel != '.' else dst_dir
+        os.makedirs(out_root, exist_ok=True)
+
+        for name in sorted(files):
+            src = os.path.join(root, name)
+            dst = os.path.join(out_root, name)
+            shutil.copyfile(src, dst)
+
+            if not name.endswith(COMPRESSIBLE):
+                continue
+            with open(src, 'rb') as f:
+                data = f.read()
+            with open(dst + '.gz', 'wb') as raw:
+                with gzip.GzipFile(filename='', mode='wb', compresslevel=9, fileobj=raw,
+                                   mtime=0) as gz:
+                    gz.write(data)
+            size_gz = os.path.getsize(dst + '.gz')
+            print('gzip_assets: %s %d -> %d bytes' % (os.path.normpath(os.path.join(rel, name)), len(data), size_gz))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit('usage: gzip_assets.py <src_dir> <staging_dir>')
+    stage(sys.argv[1], sys.argv[2])
@@ -63,6 +63,8 @@ function loadStatus() {
         document.getElementById('stat_chipid').innerText = obj.chip_id || 'n/a';
         document.getElementById('stat_mac').innerText = obj.mac_address || 'n/a';
         document.getElementById('stat_heap').innerText = obj.free_heap || 'n/a';
+        document.getElementById('stat_uptime').innerText =
+          obj.uptime_ms != null ? Math.floor(obj.uptime_ms / 1000) + ' s' : 'n/a';
       })
       .catch(err => {
         console.warn('Failed loadStatus:', err);
@@ -70,6 +72,29 @@ function loadStatus() {
       });
   }
   
+// Live updates pushed by the device (Server-Sent Events), no polling
+function subscribeEvents() {
+  if (!window.EventSource) return;
+  const events = new EventSource('/api/events');
+
+  events.addEventListener('heap', e => {
+    const d = JSON.parse(e.data);
+    document.getElementById('stat_heap').innerText = d.free_heap + ' (min ' + d.min_free_heap + ')';
+  });
+
+  events.addEventListener('wifi', e => {
+    const d = JSON.parse(e.data);
+    document.getElementById('stat_wifi').innerText =
+      d.connected ? 'connected, ' + d.rssi + ' dBm' : 'disconnected (reason ' + d.reason + ')';
+  });
+
+  events.addEventListener('weather', e => {
+    const d = JSON.parse(e.data);
+    document.getElementById('stat_weather').innerText =
+      d.temperature + ' °C, ' + d.humidity + ' % (fetched in ' + d.fetch_ms + ' ms)';
+  });
+}
+
 function saveConfig() {
   const lat = normalizeNumberInput("latitude");
   const lon = normalizeNumberInput("longitude");
@@ -96,5 +121,6 @@ function saveConfig() {
 window.onload = function() {
     loadStatus();
     loadConfig();
+    subscribeEvents();
 };
   
\ No newline at end of file
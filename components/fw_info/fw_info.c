@@ -1,32 +1,276 @@
 #include "fw_info.h"
+#include "sdkconfig.h"
 #include "esp_system.h"
 #include "esp_chip_info.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_idf_version.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* The host build has no efuse MAC, no SPI flash and no heap_caps regions */
+#if !CONFIG_IDF_TARGET_LINUX
 #include "esp_mac.h"
 #include "esp_heap_caps.h"
 #include "esp_flash.h"
-
-#include <string.h>
+#endif
 
 // FW Version
 #define FW_VERSION "1.0.0"
 
-void fw_info_load(fw_info_t *info)
+/* Immutable part, filled once by fw_info_init() */
+static fw_info_t static_info;
+
+enum { INFO_EMPTY, INFO_PROBING, INFO_READY };
+static atomic_int info_state = INFO_EMPTY;
+
+static const char *chip_model_name(esp_chip_model_t model)
 {
+    switch (model) {
+    case CHIP_ESP32:
+        return "ESP32";
+    case CHIP_ESP32S2:
+        return "ESP32-S2";
+    case CHIP_ESP32S3:
+        return "ESP32-S3";
+    case CHIP_ESP32C2:
+        return "ESP32-C2";
+    case CHIP_ESP32C3:
+        return "ESP32-C3";
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+    case CHIP_ESP32C5:
+        return "ESP32-C5";
+    case CHIP_ESP32C61:
+        return "ESP32-C61";
+#endif
+    case CHIP_ESP32C6:
+        return "ESP32-C6";
+    case CHIP_ESP32H2:
+        return "ESP32-H2";
+    case CHIP_ESP32P4:
+        return "ESP32-P4";
+    case CHIP_POSIX_LINUX:
+        return "Linux (host)";
+    default:
+        return "Unknown";
+    }
+}
+
+void fw_info_init(void)
+{
+    /* First caller probes; concurrent callers wait until the cache is filled */
+    int expected = INFO_EMPTY;
+    if (!atomic_compare_exchange_strong(&info_state, &expected, INFO_PROBING)) {
+        while (atomic_load(&info_state) != INFO_READY)
+            vTaskDelay(1);
+        return;
+    }
+
+    fw_info_t info = { 0 };
+
     esp_chip_info_t chip;
     esp_chip_info(&chip);
 
-    uint8_t mac[6];
+    uint8_t mac[6] = { 0 };
+#if !CONFIG_IDF_TARGET_LINUX
     esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    esp_flash_get_size(NULL, &info.flash_size);
+#endif
 
-    info->version = FW_VERSION;
-    info->build_date = __DATE__ " " __TIME__;
+    info.version = FW_VERSION;
+    info.build_date = __DATE__ " " __TIME__;
+    info.chip_model = chip_model_name(chip.model);
+    info.chip_revision = chip.revision;
+    info.chip_cores = chip.cores;
+    info.chip_id = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | (uint32_t)mac[5];
+    memcpy(info.mac_addr, mac, 6);
 
-    /* To others versions of ESP32, implement it! */
-    info->chip_model = (chip.model == CHIP_ESP32) ? "ESP32" : "Unknown";
+    static_info = info;
+    atomic_store(&info_state, INFO_READY);
+}
 
-    esp_flash_get_size(NULL, &(info->flash_size));
-    info->chip_id = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | (uint32_t)mac[5];
+void fw_info_load(fw_info_t *info)
+{
+    fw_info_init();
+    *info = static_info;
 
-    memcpy(info->mac_addr, mac, 6);
     info->free_heap = esp_get_free_heap_size();
+    info->min_free_heap = esp_get_minimum_free_heap_size();
+#if CONFIG_IDF_TARGET_LINUX
+    info->largest_free_block = 0;  // glibc has no largest-block query
+#else
+    info->largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+#endif
+    info->uptime_ms = (uint64_t)(esp_timer_get_time() / 1000);
+}
+
+/* ----------------- Task profiling ----------------- */
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+
+static const char *TAG = "FW_INFO";
+
+/* Ring of cumulative run-time counters, one slot per sample, so any window up
+ * to FW_INFO_TASK_WINDOW samples is a difference of two slots */
+#define RING_SLOTS (FW_INFO_TASK_WINDOW + 1)
+
+typedef struct {
+    UBaseType_t task_number;  ///< 0 marks a free slot
+    TaskHandle_t handle;
+    uint32_t runtime[RING_SLOTS];
+} task_track_t;
+
+static task_track_t tracks[FW_INFO_MAX_TASKS];
+static uint32_t wall[RING_SLOTS];         ///< Total run-time counter per sample
+static uint32_t sample_index = 0;         ///< Number of samples taken
+static TaskStatus_t status_buf[FW_INFO_MAX_TASKS];
+
+static fw_info_tasks_t snapshot;
+static SemaphoreHandle_t snapshot_lock = NULL;
+static esp_timer_handle_t sample_timer = NULL;
+
+static task_track_t *track_find(const TaskStatus_t *st)
+{
+    task_track_t *free_slot = NULL;
+    for (size_t i = 0; i < FW_INFO_MAX_TASKS; i++) {
+        if (tracks[i].task_number == st->xTaskNumber)
+            return &tracks[i];
+        if (!free_slot && tracks[i].task_number == 0)
+            free_slot = &tracks[i];
+    }
+    if (!free_slot)
+        return NULL;
+
+    /* New task: no history yet, so every window starts at its current count */
+    free_slot->task_number = st->xTaskNumber;
+    free_slot->handle = st->xHandle;
+    for (size_t s = 0; s < RING_SLOTS; s++)
+        free_slot->runtime[s] = st->ulRunTimeCounter;
+    return free_slot;
+}
+
+/* Share of one core in 0.1 %; counters are unsigned so wrap-around cancels out */
+static uint16_t permille(uint32_t busy, uint32_t span)
+{
+    if (span == 0)
+        return 0;
+    uint64_t p = (uint64_t)busy * 1000 / span;
+    return p > 1000 ? 1000 : (uint16_t)p;
 }
+
+static void sample_timer_cb(void *arg)
+{
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(status_buf, FW_INFO_MAX_TASKS, &total);
+    if (n == 0) {
+        ESP_LOGW(TAG, "More than %d tasks, profiling skipped", FW_INFO_MAX_TASKS);
+        return;
+    }
+
+    uint32_t slot = sample_index % RING_SLOTS;
+    uint32_t taken = sample_index < FW_INFO_TASK_WINDOW ? sample_index : FW_INFO_TASK_WINDOW;
+    uint32_t prev = (sample_index + RING_SLOTS - 1) % RING_SLOTS;
+    uint32_t oldest = (sample_index + RING_SLOTS - taken) % RING_SLOTS;
+    wall[slot] = total;
+    sample_index++;
+
+    /* Drop tasks that were deleted since the last sample */
+    for (size_t i = 0; i < FW_INFO_MAX_TASKS; i++) {
+        bool alive = false;
+        for (UBaseType_t t = 0; t < n && !alive; t++)
+            alive = (tracks[i].task_number == status_buf[t].xTaskNumber);
+        if (!alive)
+            tracks[i].task_number = 0;
+    }
+
+    uint32_t span_short = total - wall[prev];
+    uint32_t span_window = total - wall[oldest];
+
+    xSemaphoreTake(snapshot_lock, portMAX_DELAY);
+    snapshot.window_ms = span_window / 1000;  // run-time counter ticks in µs (esp_timer)
+    snapshot.core_count = portNUM_PROCESSORS;
+    snapshot.task_count = 0;
+
+    for (UBaseType_t t = 0; t < n; t++) {
+        const TaskStatus_t *st = &status_buf[t];
+        task_track_t *tr = track_find(st);
+        if (!tr)
+            continue;
+        tr->runtime[slot] = st->ulRunTimeCounter;
+
+        fw_info_task_t *out = &snapshot.tasks[snapshot.task_count++];
+        strlcpy(out->name, st->pcTaskName, sizeof(out->name));
+        out->priority = st->uxCurrentPriority;
+        out->state = st->eCurrentState;
+        BaseType_t core = xTaskGetCoreID(st->xHandle);
+        out->core = (core == tskNO_AFFINITY) ? -1 : (int8_t)core;
+        out->cpu_short = permille(tr->runtime[slot] - tr->runtime[prev], span_short);
+        out->cpu_window = permille(tr->runtime[slot] - tr->runtime[oldest], span_window);
+        out->stack_free = st->usStackHighWaterMark;  // Bytes on ESP-IDF (StackType_t is 8 bit)
+
+        /* Core load is whatever that core's idle task did not get */
+        for (int c = 0; c < portNUM_PROCESSORS && c < FW_INFO_MAX_CORES; c++) {
+            if (st->xHandle == xTaskGetIdleTaskHandleForCore(c)) {
+                snapshot.core_short[c] = 1000 - out->cpu_short;
+                snapshot.core_window[c] = 1000 - out->cpu_window;
+            }
+        }
+    }
+    xSemaphoreGive(snapshot_lock);
+}
+
+esp_err_t fw_info_tasks_start(void)
+{
+    if (sample_timer)
+        return ESP_OK;
+
+    snapshot_lock = xSemaphoreCreateMutex();
+    if (!snapshot_lock)
+        return ESP_ERR_NO_MEM;
+
+    const esp_timer_create_args_t args = {
+        .callback = sample_timer_cb,
+        .name = "fw_tasks",
+    };
+    esp_err_t err = esp_timer_create(&args, &sample_timer);
+    if (err == ESP_OK)
+        err = esp_timer_start_periodic(sample_timer, FW_INFO_TASK_SAMPLE_MS * 1000ULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Task sampler start failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    sample_timer_cb(NULL);  // Baseline, so the first window is one period away
+    return ESP_OK;
+}
+
+esp_err_t fw_info_get_tasks(fw_info_tasks_t *out)
+{
+    if (!out)
+        return ESP_ERR_INVALID_ARG;
+    if (!snapshot_lock)
+        return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(snapshot_lock, portMAX_DELAY);
+    *out = snapshot;
+    xSemaphoreGive(snapshot_lock);
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t fw_info_tasks_start(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t fw_info_get_tasks(fw_info_tasks_t *out)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
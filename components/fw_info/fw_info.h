@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,28 +44,120 @@ extern "C" {
  * @var fw_info_t::chip_id
  *     Unique identifier derived from chip eFuse values.
  *
+ * @var fw_info_t::chip_revision
+ *     Silicon revision as major * 100 + minor (e.g. 301 for v3.1).
+ *
+ * @var fw_info_t::chip_cores
+ *     Number of CPU cores.
+ *
  * @var fw_info_t::free_heap
  *     Current free heap memory available in bytes.
+ *
+ * @var fw_info_t::min_free_heap
+ *     Lowest free heap seen since boot, in bytes.
+ *
+ * @var fw_info_t::largest_free_block
+ *     Largest allocatable heap block in bytes (fragmentation indicator);
+ *     0 on the linux target, where it is not measured.
+ *
+ * @var fw_info_t::uptime_ms
+ *     Time since boot in milliseconds.
  */
 typedef struct {
+    /* Immutable after boot, computed once */
     const char *version;
     const char *build_date;
     const char *chip_model;
     uint32_t flash_size;
     uint8_t mac_addr[6];
     uint32_t chip_id;
+    uint16_t chip_revision;
+    uint8_t chip_cores;
+
+    /* Sampled on every fw_info_load() call */
     size_t free_heap;
+    size_t min_free_heap;
+    size_t largest_free_block;
+    uint64_t uptime_ms;
 } fw_info_t;
 
+/**
+ * @brief Probe the immutable device information once.
+ *
+ * Chip info, MAC and flash size never change after boot, so they are read
+ * here a single time and served from a cache afterwards. Called at boot by
+ * app_main, and lazily by fw_info_load(). Safe to call from several tasks:
+ * callers arriving while another one probes wait until the cache is filled.
+ */
+void fw_info_init(void);
+
 /**
  * @brief Load firmware and hardware information into a @ref fw_info_t structure.
  *
- * Populates every field of the provided structure by querying ESP-IDF APIs.
+ * Copies the cached immutable fields and samples only the dynamic ones
+ * (heap figures and uptime).
  *
  * @param[out] info Pointer to structure to be populated.
  */
 void fw_info_load(fw_info_t *info);
 
+#define FW_INFO_MAX_TASKS 32          ///< Tasks tracked by the profiler
+#define FW_INFO_MAX_CORES 2
+#define FW_INFO_TASK_SAMPLE_MS 1000   ///< Sampling period
+#define FW_INFO_TASK_WINDOW 10        ///< Long window, in samples
+
+/**
+ * @brief Per-task profile. CPU figures are a share of one core in 0.1 %
+ *        (1000 = one core fully busy).
+ */
+typedef struct {
+    char name[16];
+    uint8_t priority;
+    uint8_t state;          ///< eTaskState
+    int8_t core;            ///< Pinned core, -1 when unpinned
+    uint16_t cpu_short;     ///< Over the last sample period
+    uint16_t cpu_window;    ///< Over the last FW_INFO_TASK_WINDOW periods
+    uint32_t stack_free;    ///< Lowest stack headroom since creation, in bytes
+} fw_info_task_t;
+
+/**
+ * @brief Snapshot of the task profiler.
+ */
+typedef struct {
+    uint32_t window_ms;                         ///< Actual length of the long window
+    uint8_t core_count;
+    uint16_t core_short[FW_INFO_MAX_CORES];     ///< Core load in 0.1 %, last period
+    uint16_t core_window[FW_INFO_MAX_CORES];    ///< Core load in 0.1 %, long window
+    size_t task_count;
+    fw_info_task_t tasks[FW_INFO_MAX_TASKS];
+} fw_info_tasks_t;
+
+/**
+ * @brief Start the periodic task profiler.
+ *
+ * Samples uxTaskGetSystemState() every FW_INFO_TASK_SAMPLE_MS from an
+ * esp_timer and keeps per-task and per-core CPU load over a short and a
+ * sliding long window, plus stack high-water marks. Safe to call again.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_SUPPORTED if FreeRTOS trace facility or run-time stats are disabled
+ *      - ESP_ERR_NO_MEM / timer errors otherwise
+ */
+esp_err_t fw_info_tasks_start(void);
+
+/**
+ * @brief Copy the latest task profile.
+ *
+ * @param[out] out Snapshot to fill.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the profiler was not started
+ *      - ESP_ERR_NOT_SUPPORTED if FreeRTOS run-time stats are disabled
+ */
+esp_err_t fw_info_get_tasks(fw_info_tasks_t *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,21 @@
+/*
+ * Host (linux target) stand-in for gpio_handler.c: the config button is
+ * "pressed" when WEATHER_CONFIG_BUTTON=1 is set in the environment.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "gpio_handler.h"
+#include "esp_log.h"
+
+static const char *TAG = "GPIO_HANDLER";
+
+void gpio_handler_init(void)
+{
+    ESP_LOGI(TAG, "Host build: config button read from WEATHER_CONFIG_BUTTON");
+}
+
+bool gpio_handler_is_config_button_pressed(void)
+{
+    const char *v = getenv("WEATHER_CONFIG_BUTTON");
+    return v && strcmp(v, "1") == 0;
+}
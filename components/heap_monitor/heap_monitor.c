@@ -0,0 +1,171 @@
+#include "heap_monitor.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+/* Host build: glibc malloc underneath, no heap_caps regions */
+#include <malloc.h>
+#define block_size(ptr) malloc_usable_size(ptr)
+#else
+#define block_size(ptr) heap_caps_get_allocated_size(ptr)
+#endif
+
+static const char *TAG = "HEAP_MON";
+
+typedef struct {
+    atomic_uint_fast32_t allocs;
+    atomic_uint_fast32_t frees;
+    atomic_uint_fast32_t live;
+    atomic_uint_fast32_t peak;
+    atomic_uint_fast32_t total;
+} module_counters_t;
+
+static const char *const module_names[HEAP_MODULE_COUNT] = {
+    [HEAP_MODULE_JSON] = "json",
+    [HEAP_MODULE_HTTP_SERVER] = "http_server",
+    [HEAP_MODULE_FS] = "fs",
+    [HEAP_MODULE_HISTORY] = "history",
+};
+
+static module_counters_t modules[HEAP_MODULE_COUNT];
+
+static heap_sample_t samples[HEAP_MONITOR_SAMPLES];
+static uint32_t sample_count = 0;  ///< Total taken; slot is sample_count % HEAP_MONITOR_SAMPLES
+static portMUX_TYPE sample_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t sample_timer = NULL;
+
+/* ----------------- Accounting ----------------- */
+
+static void account_alloc(heap_module_t module, void *ptr)
+{
+    if (!ptr || module >= HEAP_MODULE_COUNT)
+        return;
+
+    module_counters_t *m = &modules[module];
+    uint32_t size = block_size(ptr);
+    atomic_fetch_add_explicit(&m->allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&m->total, size, memory_order_relaxed);
+    uint32_t live = atomic_fetch_add_explicit(&m->live, size, memory_order_relaxed) + size;
+
+    uint_fast32_t peak = atomic_load_explicit(&m->peak, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&m->peak, &peak, live,
+                                                                 memory_order_relaxed,
+                                                                 memory_order_relaxed)) {
+    }
+}
+
+void *heap_monitor_malloc(heap_module_t module, size_t size)
+{
+    void *ptr = malloc(size);
+    account_alloc(module, ptr);
+    return ptr;
+}
+
+void *heap_monitor_calloc(heap_module_t module, size_t n, size_t size)
+{
+    void *ptr = calloc(n, size);
+    account_alloc(module, ptr);
+    return ptr;
+}
+
+void heap_monitor_free(heap_module_t module, void *ptr)
+{
+    if (!ptr)
+        return;
+    if (module < HEAP_MODULE_COUNT) {
+        module_counters_t *m = &modules[module];
+        atomic_fetch_add_explicit(&m->frees, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&m->live, block_size(ptr), memory_order_relaxed);
+    }
+    free(ptr);
+}
+
+void heap_monitor_get_module(heap_module_t module, heap_module_stats_t *out)
+{
+    if (!out || module >= HEAP_MODULE_COUNT)
+        return;
+    module_counters_t *m = &modules[module];
+    out->allocs = atomic_load_explicit(&m->allocs, memory_order_relaxed);
+    out->frees = atomic_load_explicit(&m->frees, memory_order_relaxed);
+    out->live_bytes = atomic_load_explicit(&m->live, memory_order_relaxed);
+    out->peak_bytes = atomic_load_explicit(&m->peak, memory_order_relaxed);
+    out->total_bytes = atomic_load_explicit(&m->total, memory_order_relaxed);
+}
+
+const char *heap_monitor_module_name(heap_module_t module)
+{
+    return (module < HEAP_MODULE_COUNT) ? module_names[module] : "unknown";
+}
+
+/* ----------------- Trend sampler ----------------- */
+
+static void sample_timer_cb(void *arg)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct mallinfo2 mi = mallinfo2();
+    heap_sample_t s = {
+        .uptime_s = (uint32_t)(esp_timer_get_time() / 1000000),
+        .free_bytes = (uint32_t)mi.fordblks,  // largest_free and min_free are not measured
+    };
+#else
+    heap_sample_t s = {
+        .uptime_s = (uint32_t)(esp_timer_get_time() / 1000000),
+        .free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT),
+        .largest_free = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+        .min_free = esp_get_minimum_free_heap_size(),
+    };
+#endif
+
+    portENTER_CRITICAL(&sample_lock);
+    samples[sample_count % HEAP_MONITOR_SAMPLES] = s;
+    sample_count++;
+    portEXIT_CRITICAL(&sample_lock);
+
+    ESP_LOGD(TAG, "free=%u largest=%u min=%u", (unsigned)s.free_bytes,
+             (unsigned)s.largest_free, (unsigned)s.min_free);
+}
+
+size_t heap_monitor_get_samples(heap_sample_t *out, size_t max)
+{
+    if (!out)
+        return 0;
+
+    portENTER_CRITICAL(&sample_lock);
+    uint32_t total = sample_count;
+    size_t n = (total < HEAP_MONITOR_SAMPLES) ? total : HEAP_MONITOR_SAMPLES;
+    if (n > max)
+        n = max;
+    for (size_t i = 0; i < n; i++)
+        out[i] = samples[(total - n + i) % HEAP_MONITOR_SAMPLES];
+    portEXIT_CRITICAL(&sample_lock);
+    return n;
+}
+
+/* ----------------- Init ----------------- */
+
+esp_err_t heap_monitor_init(void)
+{
+    if (sample_timer)
+        return ESP_OK;
+
+    const esp_timer_create_args_t args = {
+        .callback = sample_timer_cb,
+        .name = "heap_mon",
+    };
+    esp_err_t err = esp_timer_create(&args, &sample_timer);
+    if (err == ESP_OK)
+        err = esp_timer_start_periodic(sample_timer, HEAP_MONITOR_SAMPLE_PERIOD_S * 1000000ULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Sampler start failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    sample_timer_cb(NULL);  // Boot baseline
+    return ESP_OK;
+}
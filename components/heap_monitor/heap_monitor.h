@@ -0,0 +1,103 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file heap_monitor.h
+ * @brief Per-module heap accounting and fragmentation trend.
+ *
+ * Components allocate through heap_monitor_malloc() / heap_monitor_free()
+ * with their module id; cJSON heap allocations are routed here by the
+ * json_arena hooks. Block sizes come from heap_caps_get_allocated_size(), so
+ * no header is added to allocations. A periodic sampler keeps total free,
+ * largest free block and minimum free heap, so leaks and fragmentation show
+ * up as trends rather than as a single snapshot. The linux target only
+ * measures the total free heap (glibc mallinfo2()).
+ */
+
+#define HEAP_MONITOR_SAMPLE_PERIOD_S 60  ///< Trend sampling period
+#define HEAP_MONITOR_SAMPLES 60          ///< Trend length (one hour)
+
+/** Accounted modules. */
+typedef enum {
+    HEAP_MODULE_JSON = 0,     ///< cJSON allocations made outside an arena
+    HEAP_MODULE_HTTP_SERVER,  ///< Request bodies, sessions, SSE frames, cached assets
+    HEAP_MODULE_FS,           ///< Whole-file buffers from fs_handler
+    HEAP_MODULE_HISTORY,      ///< History log sector index
+    HEAP_MODULE_COUNT
+} heap_module_t;
+
+/** Counters of one module. */
+typedef struct {
+    uint32_t allocs;       ///< Successful allocations
+    uint32_t frees;        ///< Frees
+    uint32_t live_bytes;   ///< Bytes currently allocated
+    uint32_t peak_bytes;   ///< Highest live_bytes seen
+    uint32_t total_bytes;  ///< Bytes allocated since boot, wraps at 4 GiB
+} heap_module_stats_t;
+
+/** One point of the heap trend. */
+typedef struct {
+    uint32_t uptime_s;       ///< Time of the sample
+    uint32_t free_bytes;     ///< Total free 8-bit capable heap
+    uint32_t largest_free;   ///< Largest allocatable block, 0 on linux (not measured)
+    uint32_t min_free;       ///< Lowest free heap since boot, 0 on linux (not measured)
+} heap_sample_t;
+
+/**
+ * @brief Start the trend sampler.
+ *
+ * @return
+ *  - ESP_OK on success (also when already running).
+ *  - esp_timer error code otherwise.
+ */
+esp_err_t heap_monitor_init(void);
+
+/**
+ * @brief malloc() accounted to a module.
+ */
+void *heap_monitor_malloc(heap_module_t module, size_t size);
+
+/**
+ * @brief calloc() accounted to a module.
+ */
+void *heap_monitor_calloc(heap_module_t module, size_t n, size_t size);
+
+/**
+ * @brief free() of a block obtained from heap_monitor_malloc() / _calloc()
+ *        with the same module. NULL is ignored.
+ */
+void heap_monitor_free(heap_module_t module, void *ptr);
+
+/**
+ * @brief Read the counters of one module.
+ */
+void heap_monitor_get_module(heap_module_t module, heap_module_stats_t *out);
+
+/**
+ * @brief Short module name ("json", "http_server", ...).
+ */
+const char *heap_monitor_module_name(heap_module_t module);
+
+/**
+ * @brief Copy the heap trend, oldest sample first.
+ *
+ * @param[out] out Destination array.
+ * @param max      Capacity of @p out.
+ *
+ * @return Number of samples copied.
+ */
+size_t heap_monitor_get_samples(heap_sample_t *out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HEAP_MONITOR_H
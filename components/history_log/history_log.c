@@ -0,0 +1,340 @@
+#include "history_log.h"
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "heap_monitor.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "HISTORY_LOG";
+
+#define HISTORY_PARTITION_LABEL "history"
+
+/* Flash layout: each sector starts with one header slot, then records */
+#define SECTOR_SIZE 4096
+#define RECORD_SIZE sizeof(history_record_t)
+#define RECORDS_PER_SECTOR (SECTOR_SIZE / RECORD_SIZE - 1)
+
+#define SECTOR_MAGIC 0x474F4C48  // "HLOG"
+#define TS_EMPTY UINT32_MAX      // Erased flash reads as 0xFF
+
+_Static_assert(sizeof(history_record_t) == 16, "history_record_t must stay 16 bytes");
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t sequence;  ///< Increments for every new sector, orders the ring
+    uint32_t reserved;
+    uint32_t crc;       ///< CRC32 of the previous fields
+} sector_header_t;
+
+_Static_assert(sizeof(sector_header_t) == RECORD_SIZE, "header must fill one record slot");
+
+static const esp_partition_t *part = NULL;
+static const uint8_t *base = NULL;  // Memory-mapped partition
+static esp_partition_mmap_handle_t mmap_handle;
+static SemaphoreHandle_t lock = NULL;
+
+static uint32_t sector_count;
+static uint32_t *first_ts = NULL;  // Sparse index: first timestamp of each sector
+static uint32_t oldest_sector;
+static uint32_t head_sector;
+static uint32_t head_seq;
+static uint32_t head_fill;  // Records used in the head sector
+static uint32_t last_ts;
+
+/* ----------------- Flash access ----------------- */
+
+static const sector_header_t *header_at(uint32_t sector)
+{
+    return (const sector_header_t *)(base + (size_t)sector * SECTOR_SIZE);
+}
+
+static const history_record_t *record_at(uint32_t sector, uint32_t index)
+{
+    return (const history_record_t *)(base + (size_t)sector * SECTOR_SIZE +
+                                      (index + 1) * RECORD_SIZE);
+}
+
+static bool header_valid(const sector_header_t *h)
+{
+    return h->magic == SECTOR_MAGIC &&
+           h->crc == esp_rom_crc32_le(0, (const uint8_t *)h, offsetof(sector_header_t, crc));
+}
+
+static uint16_t record_crc(const history_record_t *rec)
+{
+    return esp_rom_crc16_le(0, (const uint8_t *)rec, offsetof(history_record_t, crc));
+}
+
+static bool record_valid(const history_record_t *rec)
+{
+    return rec->timestamp != TS_EMPTY && rec->crc == record_crc(rec);
+}
+
+/**
+ * @brief Count used slots of a sector. Records are written in order, so the
+ *        used slots form a prefix and a binary search finds its end.
+ */
+static uint32_t sector_fill(uint32_t sector)
+{
+    uint32_t lo = 0, hi = RECORDS_PER_SECTOR;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (record_at(sector, mid)->timestamp != TS_EMPTY)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Erase a sector and make it the new head of the log.
+ */
+static esp_err_t start_sector(uint32_t sector, uint32_t seq)
+{
+    esp_err_t err = esp_partition_erase_range(part, (size_t)sector * SECTOR_SIZE, SECTOR_SIZE);
+    if (err != ESP_OK)
+        return err;
+
+    sector_header_t h = { .magic = SECTOR_MAGIC, .sequence = seq };
+    h.crc = esp_rom_crc32_le(0, (const uint8_t *)&h, offsetof(sector_header_t, crc));
+    err = esp_partition_write(part, (size_t)sector * SECTOR_SIZE, &h, sizeof(h));
+    if (err != ESP_OK)
+        return err;
+
+    first_ts[sector] = TS_EMPTY;
+    head_sector = sector;
+    head_seq = seq;
+    head_fill = 0;
+
+    // Wrapped onto the oldest sector: its data is gone, the next one is now the oldest
+    if (sector == oldest_sector && sector_count > 1) {
+        uint32_t next = (sector + 1) % sector_count;
+        if (header_valid(header_at(next)))
+            oldest_sector = next;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Map a position in ring order (0 = oldest sector) to a physical sector.
+ */
+static inline uint32_t ring_sector(uint32_t oldest, uint32_t pos)
+{
+    return (oldest + pos) % sector_count;
+}
+
+/* ----------------- Public API ----------------- */
+
+esp_err_t history_log_init(void)
+{
+    if (base)
+        return ESP_OK;
+
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, HISTORY_PARTITION_SUBTYPE,
+                                    HISTORY_PARTITION_LABEL);
+    if (!part) {
+        ESP_LOGE(TAG, "No '%s' partition", HISTORY_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    sector_count = part->size / SECTOR_SIZE;
+    first_ts = heap_monitor_calloc(HEAP_MODULE_HISTORY, sector_count, sizeof(uint32_t));
+    lock = xSemaphoreCreateMutex();
+    if (!first_ts || !lock) {
+        heap_monitor_free(HEAP_MODULE_HISTORY, first_ts);
+        first_ts = NULL;
+        if (lock)
+            vSemaphoreDelete(lock);
+        lock = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    const void *ptr;
+    esp_err_t err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr,
+                                       &mmap_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mmap failed: %s", esp_err_to_name(err));
+        heap_monitor_free(HEAP_MODULE_HISTORY, first_ts);
+        first_ts = NULL;
+        vSemaphoreDelete(lock);
+        lock = NULL;
+        return err;
+    }
+    base = ptr;
+
+    /* Rebuild the sector index; the highest sequence is the head, the lowest the oldest */
+    bool any = false;
+    uint32_t min_seq = UINT32_MAX;
+    for (uint32_t s = 0; s < sector_count; s++) {
+        const sector_header_t *h = header_at(s);
+        if (!header_valid(h)) {
+            first_ts[s] = TS_EMPTY;
+            continue;
+        }
+        first_ts[s] = record_at(s, 0)->timestamp;
+        if (!any || h->sequence > head_seq) {
+            head_seq = h->sequence;
+            head_sector = s;
+        }
+        if (h->sequence < min_seq) {
+            min_seq = h->sequence;
+            oldest_sector = s;
+        }
+        any = true;
+    }
+
+    if (!any) {
+        ESP_LOGI(TAG, "Formatting empty history log");
+        oldest_sector = 0;
+        err = start_sector(0, 1);
+        if (err != ESP_OK)
+            return err;
+    }
+
+    head_fill = sector_fill(head_sector);
+    last_ts = 0;
+    for (uint32_t i = head_fill; i > 0; i--) {
+        const history_record_t *rec = record_at(head_sector, i - 1);
+        if (record_valid(rec)) {
+            last_ts = rec->timestamp;
+            break;
+        }
+    }
+    if (last_ts == 0 && head_sector != oldest_sector) {
+        // Head just started: the newest record is at the end of the previous sector
+        uint32_t prev = (head_sector + sector_count - 1) % sector_count;
+        for (uint32_t i = RECORDS_PER_SECTOR; i > 0; i--) {
+            const history_record_t *rec = record_at(prev, i - 1);
+            if (record_valid(rec)) {
+                last_ts = rec->timestamp;
+                break;
+            }
+        }
+    }
+
+    history_log_info_t info;
+    history_log_get_info(&info);
+    ESP_LOGI(TAG, "History: %u/%u records over %u sectors (head %u)", (unsigned)info.count,
+             (unsigned)info.capacity, (unsigned)sector_count, (unsigned)head_sector);
+    return ESP_OK;
+}
+
+esp_err_t history_log_append(const history_record_t *rec)
+{
+    if (!base)
+        return ESP_ERR_INVALID_STATE;
+    if (!rec || rec->timestamp == TS_EMPTY)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = ESP_OK;
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    if (rec->timestamp == last_ts) {
+        ESP_LOGD(TAG, "Duplicate sample %u dropped", (unsigned)rec->timestamp);
+        goto out;
+    }
+    if (rec->timestamp < last_ts) {
+        ESP_LOGW(TAG, "Sample %u older than newest record %u", (unsigned)rec->timestamp,
+                 (unsigned)last_ts);
+        err = ESP_ERR_INVALID_ARG;
+        goto out;
+    }
+
+    if (head_fill == RECORDS_PER_SECTOR) {
+        err = start_sector((head_sector + 1) % sector_count, head_seq + 1);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Sector rotation failed: %s", esp_err_to_name(err));
+            goto out;
+        }
+    }
+
+    history_record_t r = *rec;
+    r.reserved = 0;
+    r.crc = record_crc(&r);
+
+    size_t offset = (size_t)head_sector * SECTOR_SIZE + (head_fill + 1) * RECORD_SIZE;
+    err = esp_partition_write(part, offset, &r, sizeof(r));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write failed: %s", esp_err_to_name(err));
+        // The slot may be partly written; skip it, readers drop it on CRC
+        head_fill++;
+        goto out;
+    }
+
+    if (head_fill == 0)
+        first_ts[head_sector] = r.timestamp;
+    head_fill++;
+    last_ts = r.timestamp;
+
+out:
+    xSemaphoreGive(lock);
+    return err;
+}
+
+size_t history_log_query(uint32_t from, uint32_t to, history_log_visit_cb_t cb, void *ctx)
+{
+    if (!base || !cb || from > to)
+        return 0;
+
+    /* Snapshot the ring bounds; appends only touch the head, and a wrap that
+     * erases a sector under us just shows up as records failing the CRC check */
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t oldest = oldest_sector;
+    uint32_t head = head_sector;
+    uint32_t fill = head_fill;
+    xSemaphoreGive(lock);
+
+    uint32_t used = (head + sector_count - oldest) % sector_count + 1;
+
+    /* Binary search the sparse index for the last sector starting at or before `from` */
+    uint32_t lo = 0, hi = used;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        uint32_t ts = first_ts[ring_sector(oldest, mid)];
+        if (ts != TS_EMPTY && ts <= from)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    uint32_t start = lo ? lo - 1 : 0;
+
+    size_t visited = 0;
+    for (uint32_t pos = start; pos < used; pos++) {
+        uint32_t sector = ring_sector(oldest, pos);
+        uint32_t n = (sector == head) ? fill : RECORDS_PER_SECTOR;
+        for (uint32_t i = 0; i < n; i++) {
+            const history_record_t *rec = record_at(sector, i);
+            if (!record_valid(rec) || rec->timestamp < from)
+                continue;
+            if (rec->timestamp > to)
+                return visited;
+            visited++;
+            if (!cb(rec, ctx))
+                return visited;
+        }
+    }
+    return visited;
+}
+
+void history_log_get_info(history_log_info_t *out)
+{
+    if (!out)
+        return;
+    memset(out, 0, sizeof(*out));
+    if (!base)
+        return;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t used = (head_sector + sector_count - oldest_sector) % sector_count + 1;
+    out->capacity = sector_count * RECORDS_PER_SECTOR;
+    out->count = (used - 1) * RECORDS_PER_SECTOR + head_fill;
+    out->oldest_ts = (out->count && first_ts[oldest_sector] != TS_EMPTY)
+                         ? first_ts[oldest_sector] : 0;
+    out->newest_ts = last_ts;
+    out->sector_count = sector_count;
+    xSemaphoreGive(lock);
+}
@@ -0,0 +1,124 @@
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file history_log.h
+ * @brief Append-only weather history on a dedicated flash partition.
+ *
+ * Samples are stored as fixed-size records in a circular log over the
+ * `history` partition. Sectors are erased in ring order, which spreads
+ * wear evenly over the whole partition. The partition is memory-mapped, so
+ * queries hand out pointers straight into flash (no copy), and a sparse
+ * per-sector time index lets range queries skip to the first sector of
+ * interest instead of scanning the whole log.
+ */
+
+/** Partition subtype of the history partition (custom data subtype). */
+#define HISTORY_PARTITION_SUBTYPE 0x40
+
+/** Bit of history_record_t::flags set for daytime samples. */
+#define HISTORY_FLAG_IS_DAY (1 << 0)
+
+/**
+ * @brief One stored weather sample (16 bytes).
+ *
+ * Fixed-point fields keep the record compact: divide by 100 to get the
+ * value in its unit.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;          ///< Unix time (UTC) of the sample
+    int16_t temperature_x100;    ///< Air temperature in 0.01 °C
+    uint16_t humidity_x100;      ///< Relative humidity in 0.01 %
+    uint16_t precipitation_x100; ///< Precipitation in 0.01 mm
+    uint8_t weather_code;        ///< WMO weather code
+    uint8_t flags;               ///< HISTORY_FLAG_* bits
+    uint16_t reserved;           ///< Zero
+    uint16_t crc;                ///< CRC16 of the previous bytes, set by history_log_append()
+} history_record_t;
+
+/**
+ * @brief Log usage summary.
+ */
+typedef struct {
+    uint32_t capacity;      ///< Maximum number of records the partition holds
+    uint32_t count;         ///< Records currently stored (approximate after power loss)
+    uint32_t oldest_ts;     ///< Timestamp of the oldest record (0 if empty)
+    uint32_t newest_ts;     ///< Timestamp of the newest record (0 if empty)
+    uint32_t sector_count;  ///< Flash sectors used by the log
+} history_log_info_t;
+
+/**
+ * @brief Record visitor used by history_log_query().
+ *
+ * @param rec  Record, pointing into memory-mapped flash (valid during the call).
+ * @param ctx  User context.
+ *
+ * @return true to continue, false to stop the query.
+ */
+typedef bool (*history_log_visit_cb_t)(const history_record_t *rec, void *ctx);
+
+/**
+ * @brief Map the history partition and rebuild the in-RAM sector index.
+ *
+ * Safe to call multiple times.
+ *
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_NOT_FOUND if the partition table has no history partition.
+ *  - esp_err_t on other failures.
+ */
+esp_err_t history_log_init(void);
+
+/**
+ * @brief Append one sample to the log.
+ *
+ * Timestamps must not decrease. A sample with the same timestamp as the
+ * newest record is a duplicate (Open-Meteo updates every 15 minutes) and
+ * is dropped without writing flash.
+ *
+ * @param rec Sample to store; `crc` is computed here.
+ *
+ * @return
+ *  - ESP_OK on success (or duplicate dropped).
+ *  - ESP_ERR_INVALID_STATE if the log is not initialized.
+ *  - ESP_ERR_INVALID_ARG for a NULL record or a timestamp older than the newest record.
+ *  - esp_err_t on flash errors.
+ */
+esp_err_t history_log_append(const history_record_t *rec);
+
+/**
+ * @brief Visit all records with `from <= timestamp <= to`, oldest first.
+ *
+ * The sector index is binary-searched for the start position; the visitor
+ * reads directly from mapped flash.
+ *
+ * @param from  First timestamp of interest (inclusive).
+ * @param to    Last timestamp of interest (inclusive).
+ * @param cb    Visitor called for each record.
+ * @param ctx   User context passed to the visitor.
+ *
+ * @return Number of records visited.
+ */
+size_t history_log_query(uint32_t from, uint32_t to, history_log_visit_cb_t cb, void *ctx);
+
+/**
+ * @brief Get a usage summary of the log.
+ *
+ * @param[out] out Structure to fill.
+ */
+void history_log_get_info(history_log_info_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HISTORY_LOG_H
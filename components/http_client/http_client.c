@@ -1,8 +1,14 @@
 #include <string.h>
+#include <strings.h>
+#include <stdlib.h>
 #include "esp_log.h"
 #include "esp_crt_bundle.h"
 #include "esp_http_client.h"
 #include "esp_err.h"
+#include "esp_timer.h"
+#include "http_client.h"
+#include "power_manager.h"
+#include "trace_recorder.h"
 
 static const char *TAG = "HTTP_CLIENT";
 
@@ -13,8 +19,26 @@ typedef struct {
     char *buffer;
     size_t max_len;
     size_t len;
+    bool in_handshake;  ///< TLS hot section held until the connection is up
 } http_response_ctx_t;
 
+/**
+ * @brief State of one GET
+ */
+typedef struct {
+    http_response_info_t *info;
+    bool in_handshake;
+} http_get_ctx_t;
+
+/* Leave the TLS hot section once the handshake is over (or failed) */
+static void end_handshake(http_response_ctx_t *ctx)
+{
+    if (ctx && ctx->in_handshake) {
+        ctx->in_handshake = false;
+        power_manager_section_end(POWER_SECTION_TLS);
+    }
+}
+
 /**
  * @brief Generic handler of HTTP (GET/POST) events
  */
@@ -29,6 +53,8 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
 
         case HTTP_EVENT_ON_CONNECTED:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
+            trace_instant("http_connected");
+            end_handshake(ctx);
             if (ctx)
                 ctx->len = 0;
             break;
@@ -50,6 +76,7 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
 
         case HTTP_EVENT_ON_FINISH:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH (len=%d)", (int)(ctx ? ctx->len : 0));
+            trace_instant("http_finished");
             break;
 
         case HTTP_EVENT_DISCONNECTED:
@@ -63,43 +90,146 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
+/**
+ * @brief GET events: only connection tracing and the Retry-After header,
+ *        the body is read with esp_http_client_read()
+ */
+static esp_err_t _http_get_event_handler(esp_http_client_event_t *evt)
+{
+    http_get_ctx_t *ctx = (http_get_ctx_t *)evt->user_data;
+
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            trace_instant("http_connected");
+            if (ctx && ctx->in_handshake) {
+                ctx->in_handshake = false;
+                power_manager_section_end(POWER_SECTION_TLS);
+            }
+            break;
+
+        case HTTP_EVENT_ON_HEADER:
+            if (ctx && ctx->info && evt->header_key && evt->header_value &&
+                strcasecmp(evt->header_key, "Retry-After") == 0)
+                ctx->info->retry_after_s = (uint32_t)strtoul(evt->header_value, NULL, 10);
+            break;
+
+        default:
+            break;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Read the status and body of an opened request, within the deadline
+ */
+static esp_err_t read_response(esp_http_client_handle_t client, char *buf, size_t max_len,
+                               int64_t deadline_us, http_response_info_t *info)
+{
+    int64_t content_length = esp_http_client_fetch_headers(client);
+    if (content_length < 0) {
+        ESP_LOGE(TAG, "No response headers");
+        return (content_length == -ESP_ERR_HTTP_EAGAIN) ? ESP_ERR_TIMEOUT : ESP_FAIL;
+    }
+
+    info->status = esp_http_client_get_status_code(client);
+    ESP_LOGI(TAG, "HTTP GET Status = %d", info->status);
+    if (info->status < 200 || info->status > 299)
+        return ESP_ERR_INVALID_RESPONSE;
+
+    if (content_length >= (int64_t)max_len) {
+        ESP_LOGW(TAG, "Body of %lld bytes does not fit (max=%d)", (long long)content_length,
+                 (int)max_len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t len = 0;
+    for (;;) {
+        if (esp_timer_get_time() > deadline_us) {
+            ESP_LOGW(TAG, "Deadline hit after %d body bytes", (int)len);
+            return ESP_ERR_TIMEOUT;
+        }
+        if (len == max_len - 1) {
+            if (esp_http_client_is_complete_data_received(client))
+                break;
+            ESP_LOGW(TAG, "Response buffer overflow (max=%d)", (int)max_len);
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        int n = esp_http_client_read(client, buf + len, max_len - 1 - len);
+        if (n < 0)
+            return (n == -ESP_ERR_HTTP_EAGAIN) ? ESP_ERR_TIMEOUT : ESP_FAIL;
+        if (n == 0)
+            break;
+        len += n;
+        buf[len] = '\0';
+        info->body_len = len;
+    }
+
+    if (!esp_http_client_is_complete_data_received(client)) {
+        ESP_LOGW(TAG, "Body cut short after %d bytes", (int)len);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    trace_instant("http_finished");
+    return ESP_OK;
+}
+
 /**
  * @brief Execute one HTTP GET request
  */
-esp_err_t http_get(const char *url, char *response_buffer, size_t max_len)
+esp_err_t http_get(const char *url, char *response_buffer, size_t max_len,
+                   http_response_info_t *info)
 {
     if (!url || !response_buffer || max_len == 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    http_response_ctx_t ctx = { .buffer = response_buffer, .max_len = max_len, .len = 0 };
+    http_response_info_t local_info;
+    if (!info)
+        info = &local_info;
+    *info = (http_response_info_t) { 0 };
+    response_buffer[0] = '\0';
+    http_get_ctx_t ctx = { .info = info };
 
     ESP_LOGI(TAG, "HTTP GET: %s", url);
+    trace_begin("http_get");
+    int64_t deadline_us = esp_timer_get_time() + HTTP_CLIENT_DEADLINE_MS * 1000LL;
 
     esp_http_client_config_t config = {
         .url = url,
-        .event_handler = _http_event_handler,
+        .event_handler = _http_get_event_handler,
         .user_data = &ctx,
         .crt_bundle_attach = esp_crt_bundle_attach,
-        .timeout_ms = 10000,
+        .timeout_ms = HTTP_CLIENT_IO_TIMEOUT_MS,
         .skip_cert_common_name_check = true,
     };
 
+    trace_begin("http_init");
     esp_http_client_handle_t client = esp_http_client_init(&config);
+    trace_end("http_init");
     if (!client) {
         ESP_LOGE(TAG, "Failed to initialize HTTP client");
+        trace_end("http_get");
         return ESP_FAIL;
     }
 
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        int status = esp_http_client_get_status_code(client);
-        ESP_LOGI(TAG, "HTTP GET Status = %d", status);
-    } else {
-        ESP_LOGE(TAG, "HTTP GET request failed: %s", esp_err_to_name(err));
+    /* Full CPU clock and no light sleep for the handshake only */
+    ctx.in_handshake = true;
+    power_manager_section_begin(POWER_SECTION_TLS);
+    trace_begin("http_perform");
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (ctx.in_handshake) {
+        ctx.in_handshake = false;
+        power_manager_section_end(POWER_SECTION_TLS);
     }
+    if (err == ESP_OK)
+        err = read_response(client, response_buffer, max_len, deadline_us, info);
+    trace_end("http_perform");
+    if (err != ESP_OK)
+        ESP_LOGE(TAG, "HTTP GET request failed: %s", esp_err_to_name(err));
 
     esp_http_client_cleanup(client);
+    trace_end("http_get");
     return err;
 }
 
@@ -135,7 +265,11 @@ esp_err_t http_post(const char *url, const char *post_data, char *response_buffe
     esp_http_client_set_header(client, "Content-Type", "application/json");
     esp_http_client_set_post_field(client, post_data, strlen(post_data));
 
+    /* Full CPU clock and no light sleep for the handshake only */
+    ctx.in_handshake = true;
+    power_manager_section_begin(POWER_SECTION_TLS);
     esp_err_t err = esp_http_client_perform(client);
+    end_handshake(&ctx);
     if (err == ESP_OK) {
         int status = esp_http_client_get_status_code(client);
         ESP_LOGI(TAG, "HTTP POST Status = %d", status);
@@ -3,6 +3,7 @@
 
 #include "esp_err.h"
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,20 +19,43 @@ extern "C" {
  * HTTPS is supported using ESP-IDF's built-in certificate bundle.
  */
 
+/** Timeout of each socket operation of http_get() */
+#define HTTP_CLIENT_IO_TIMEOUT_MS 5000
+
+/** Overall budget of one http_get(), so a trickling server cannot hold the caller */
+#define HTTP_CLIENT_DEADLINE_MS 15000
+
+/**
+ * @brief Outcome of a GET, filled as far as the exchange got.
+ */
+typedef struct {
+    int status;              ///< HTTP status code, 0 if no response arrived
+    size_t body_len;         ///< Body bytes stored in the buffer
+    uint32_t retry_after_s;  ///< Retry-After of the reply in seconds, 0 if absent
+} http_response_info_t;
+
 /**
  * @brief Perform an HTTP GET request.
  *
+ * The body is stored null-terminated. A body that does not fit is rejected
+ * (from Content-Length before downloading it when the server sends one), and
+ * the whole request is bounded by HTTP_CLIENT_DEADLINE_MS.
+ *
  * @param url              Full request URL (e.g., "https://api.open-meteo.com/v1/...").
  * @param response_buffer  Destination buffer to store the response body.
  * @param max_len          Maximum buffer size available for the response.
+ * @param[out] info        Status code, body length and Retry-After (may be NULL).
  *
  * @return
- *  - ESP_OK on success.
+ *  - ESP_OK if a complete 2xx body was received.
  *  - ESP_ERR_INVALID_ARG for invalid arguments.
- *  - ESP_FAIL for general failure.
- *  - Additional HTTP client error codes may be returned.
+ *  - ESP_ERR_INVALID_RESPONSE for a non-2xx status or a body cut short.
+ *  - ESP_ERR_INVALID_SIZE if the body does not fit in @p max_len - 1 bytes.
+ *  - ESP_ERR_TIMEOUT if the deadline or an I/O timeout expired.
+ *  - ESP_FAIL for connection and other failures.
  */
-esp_err_t http_get(const char *url, char *response_buffer, size_t max_len);
+esp_err_t http_get(const char *url, char *response_buffer, size_t max_len,
+                   http_response_info_t *info);
 
 /**
  * @brief Perform an HTTP POST request.
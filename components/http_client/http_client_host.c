@@ -0,0 +1,279 @@
+/*
+ * Host (linux target) stand-in for http_client.c.
+ *
+ * Plain HTTP/1.1 over POSIX sockets, so the fetch path runs on a workstation
+ * against tools/mock_open_meteo.py. No TLS: https:// URLs are rejected.
+ */
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include "esp_log.h"
+#include "esp_err.h"
+#include "http_client.h"
+#include "power_manager.h"
+#include "trace_recorder.h"
+
+static const char *TAG = "HTTP_CLIENT";
+
+#define HOST_HTTP_HEADER_MAX 1024
+
+/**
+ * @brief Split "http://host[:port]/path" into its parts.
+ */
+static esp_err_t parse_url(const char *url, char *host, size_t host_len, char *port,
+                           size_t port_len, const char **path)
+{
+    const char *prefix = "http://";
+    if (strncmp(url, prefix, strlen(prefix)) != 0) {
+        ESP_LOGE(TAG, "Host build only supports http:// URLs: %s", url);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    const char *p = url + strlen(prefix);
+    const char *slash = strchr(p, '/');
+    *path = slash ? slash : "/";
+    size_t authority_len = slash ? (size_t)(slash - p) : strlen(p);
+
+    const char *colon = memchr(p, ':', authority_len);
+    size_t name_len = colon ? (size_t)(colon - p) : authority_len;
+    if (name_len == 0 || name_len >= host_len)
+        return ESP_ERR_INVALID_ARG;
+    memcpy(host, p, name_len);
+    host[name_len] = '\0';
+
+    if (colon) {
+        size_t n = authority_len - name_len - 1;
+        if (n == 0 || n >= port_len)
+            return ESP_ERR_INVALID_ARG;
+        memcpy(port, colon + 1, n);
+        port[n] = '\0';
+    } else {
+        snprintf(port, port_len, "80");
+    }
+    return ESP_OK;
+}
+
+static int connect_to(const char *host, const char *port)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+        return -1;
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        struct timeval tv = { .tv_sec = HTTP_CLIENT_IO_TIMEOUT_MS / 1000 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static esp_err_t send_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, 0);
+        if (n <= 0)
+            return ESP_FAIL;
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Value of a response header (case-insensitive name), or NULL.
+ */
+static const char *find_header(const char *headers, const char *name)
+{
+    size_t name_len = strlen(name);
+    for (const char *line = strstr(headers, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *v = line + name_len + 1;
+            while (*v == ' ')
+                v++;
+            return v;
+        }
+    }
+    return NULL;
+}
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Send one request and copy the response body into the caller buffer.
+ */
+static esp_err_t perform(const char *method, const char *url, const char *body,
+                         char *response_buffer, size_t max_len, http_response_info_t *info)
+{
+    char host[128], port[8];
+    const char *path;
+    esp_err_t err = parse_url(url, host, sizeof(host), port, sizeof(port), &path);
+    if (err != ESP_OK)
+        return err;
+
+    int64_t deadline_us = now_us() + HTTP_CLIENT_DEADLINE_MS * 1000LL;
+    power_manager_section_begin(POWER_SECTION_TLS);
+    int fd = connect_to(host, port);
+    power_manager_section_end(POWER_SECTION_TLS);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Connect to %s:%s failed", host, port);
+        return ESP_FAIL;
+    }
+    trace_instant("http_connected");
+
+    char header[HOST_HTTP_HEADER_MAX];
+    size_t body_len = body ? strlen(body) : 0;
+    int n = snprintf(header, sizeof(header),
+                     "%s %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n"
+                     "Content-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+                     method, path, host, body_len);
+    if (n < 0 || (size_t)n >= sizeof(header) || send_all(fd, header, n) != ESP_OK ||
+        (body_len && send_all(fd, body, body_len) != ESP_OK)) {
+        close(fd);
+        return ESP_FAIL;
+    }
+
+    /* Headers first, into the local buffer; the body goes straight to the caller */
+    size_t hlen = 0;
+    char *body_start = NULL;
+    bool timed_out = false;
+    while (!body_start && hlen < sizeof(header) - 1) {
+        ssize_t r = recv(fd, header + hlen, sizeof(header) - 1 - hlen, 0);
+        if (r <= 0) {
+            timed_out = r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+        }
+        hlen += r;
+        header[hlen] = '\0';
+        body_start = strstr(header, "\r\n\r\n");
+        if (!body_start && now_us() > deadline_us) {
+            timed_out = true;
+            break;
+        }
+    }
+    if (!body_start) {
+        ESP_LOGE(TAG, "No response headers");
+        close(fd);
+        return timed_out ? ESP_ERR_TIMEOUT : ESP_FAIL;
+    }
+    body_start[2] = '\0';  // Terminate the header block for find_header()
+    body_start += 4;
+
+    sscanf(header, "HTTP/%*s %d", &info->status);
+    ESP_LOGI(TAG, "HTTP %s Status = %d", method, info->status);
+    const char *v = find_header(header, "Retry-After");
+    if (v)
+        info->retry_after_s = (uint32_t)strtoul(v, NULL, 10);
+    long long content_length = -1;
+    v = find_header(header, "Content-Length");
+    if (v)
+        content_length = strtoll(v, NULL, 10);
+    if (content_length >= (long long)max_len) {
+        ESP_LOGW(TAG, "Body of %lld bytes does not fit (max=%d)", content_length, (int)max_len);
+        close(fd);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t len = 0;
+    size_t pending = hlen - (body_start - header);
+    const char *src = body_start;
+    err = ESP_OK;
+    for (;;) {
+        size_t room = max_len - 1 - len;
+        if (pending > room) {
+            ESP_LOGW(TAG, "Response buffer overflow (max=%d)", (int)max_len);
+            err = ESP_ERR_INVALID_SIZE;
+            pending = room;
+        }
+        memcpy(response_buffer + len, src, pending);
+        len += pending;
+        if (err != ESP_OK)
+            break;
+        if (now_us() > deadline_us) {
+            ESP_LOGW(TAG, "Deadline hit after %d body bytes", (int)len);
+            err = ESP_ERR_TIMEOUT;
+            break;
+        }
+
+        ssize_t r = recv(fd, header, sizeof(header), 0);
+        if (r < 0) {
+            err = (errno == EAGAIN || errno == EWOULDBLOCK) ? ESP_ERR_TIMEOUT : ESP_FAIL;
+            break;
+        }
+        if (r == 0)
+            break;  // Connection: close ends the body
+        src = header;
+        pending = r;
+    }
+    response_buffer[len] = '\0';
+    info->body_len = len;
+    close(fd);
+
+    if (err == ESP_OK && content_length >= 0 && (long long)len != content_length) {
+        ESP_LOGW(TAG, "Body cut short after %d of %lld bytes", (int)len, content_length);
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+    if (err == ESP_OK)
+        trace_instant("http_finished");
+    return err;
+}
+
+esp_err_t http_get(const char *url, char *response_buffer, size_t max_len,
+                   http_response_info_t *info)
+{
+    if (!url || !response_buffer || max_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    http_response_info_t local_info;
+    if (!info)
+        info = &local_info;
+    *info = (http_response_info_t) { 0 };
+    response_buffer[0] = '\0';
+
+    ESP_LOGI(TAG, "HTTP GET: %s", url);
+    trace_begin("http_get");
+    esp_err_t err = perform("GET", url, NULL, response_buffer, max_len, info);
+    if (err == ESP_OK && (info->status < 200 || info->status > 299))
+        err = ESP_ERR_INVALID_RESPONSE;
+    trace_end("http_get");
+    if (err != ESP_OK)
+        ESP_LOGE(TAG, "HTTP GET request failed: %s", esp_err_to_name(err));
+    return err;
+}
+
+esp_err_t http_post(const char *url, const char *post_data, char *response_buffer, size_t max_len)
+{
+    if (!url || !post_data || !response_buffer || max_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "HTTP POST: %s", url);
+    http_response_info_t info = { 0 };
+    esp_err_t err = perform("POST", url, post_data, response_buffer, max_len, &info);
+    if (err != ESP_OK)
+        ESP_LOGE(TAG, "HTTP POST request failed: %s", esp_err_to_name(err));
+    return err;
+}
@@ -0,0 +1,20 @@
+#ifndef EMBEDDED_ASSETS_H
+#define EMBEDDED_ASSETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Table of web assets linked into the app image (CONFIG_HTTP_SERVER_ASSETS_EMBEDDED).
+ * The table itself is generated by CMakeLists.txt from the staged littlefs_data.
+ */
+typedef struct {
+    const char *path;      ///< URI path, e.g. "/index.html"
+    const uint8_t *start;  ///< First byte in mapped flash
+    const uint8_t *end;    ///< One past the last byte
+} embedded_asset_t;
+
+extern const embedded_asset_t embedded_assets[];
+extern const size_t embedded_asset_count;
+
+#endif  // EMBEDDED_ASSETS_H
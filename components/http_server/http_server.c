@@ -1,32 +1,78 @@
 #include "http_server.h"
+#include "sdkconfig.h"
 #include "esp_log.h"
-#include "nvs_manager.h"
-#include "fs_handler.h"
+#include "config_manager.h"
 #include "fw_info.h"
+#include "boot_timeline.h"
+#include "trace_recorder.h"
+#include "heap_monitor.h"
+#include "json_arena.h"
+#include "power_manager.h"
+#include "history_log.h"
+#include "esp_timer.h"
+#if CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
+#include "embedded_assets.h"
+#else
+#include "fs_handler.h"
+#endif
+#include "json_writer.h"
+#include "metrics.h"
 #include "cJSON.h"
 #include "esp_http_server.h"
+#include "esp_system.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 static const char *TAG = "HTTP_SERVER";
 static httpd_handle_t server = NULL;
 
+/* Config portal (web UI, /api/config) exposed; set by wifi_manager in config mode */
+static volatile bool portal_enabled = false;
+
 /* ----------------- Helpers ----------------- */
 
-static void send_json_obj(httpd_req_t *req, cJSON *obj)
+/* Server allocations are accounted to the http_server heap module */
+static void *srv_malloc(size_t size)
+{
+    return heap_monitor_malloc(HEAP_MODULE_HTTP_SERVER, size);
+}
+
+static void srv_free(void *ptr)
+{
+    heap_monitor_free(HEAP_MODULE_HTTP_SERVER, ptr);
+}
+
+/*
+ * JSON responses are streamed with json_writer through a small stack buffer
+ * straight into httpd_resp_send_chunk(): no cJSON tree, no printed copy.
+ */
+#define JSON_CHUNK_SIZE 256
+
+static esp_err_t httpd_chunk_sink(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+static void json_begin(httpd_req_t *req, json_writer_t *w, char *buf, size_t cap)
 {
-    char *s = cJSON_PrintUnformatted(obj);
-    if (!s) {
-        httpd_resp_send_500(req);
-        cJSON_Delete(obj);
-        return;
-    }
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, s);
-    free(s);
-    cJSON_Delete(obj);
+    json_writer_init(w, buf, cap, httpd_chunk_sink, req);
+    json_writer_object_begin(w);
+}
+
+static esp_err_t json_end(httpd_req_t *req, json_writer_t *w)
+{
+    json_writer_object_end(w);
+    esp_err_t err = json_writer_finish(w);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "JSON response aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
 /* Read request body into a heap buffer (null-terminated). Caller must free. */
@@ -38,7 +84,7 @@ static char *read_request_body(httpd_req_t *req, size_t *out_len)
     if (total_len <= 0)
         return NULL;
 
-    char *buf = malloc(total_len + 1);
+    char *buf = srv_malloc(total_len + 1);
     if (!buf)
         return NULL;
 
@@ -47,7 +93,7 @@ static char *read_request_body(httpd_req_t *req, size_t *out_len)
     while (received < total_len) {
         r = httpd_req_recv(req, buf + received, total_len - received);
         if (r <= 0) {
-            free(buf);
+            srv_free(buf);
             return NULL;
         }
         received += r;
@@ -61,18 +107,15 @@ static char *read_request_body(httpd_req_t *req, size_t *out_len)
 /* ----------------- API: /api/config (GET) ----------------- */
 static esp_err_t api_config_get_handler(httpd_req_t *req)
 {
-    char ssid[64] = { 0 };
-    char pass[64] = { 0 };
-
-    nvs_manager_read_str("wifi_ssid", ssid, sizeof(ssid));
-    nvs_manager_read_str("wifi_pass", pass, sizeof(pass));
+    app_config_t cfg;
+    config_manager_get(&cfg);
 
-    cJSON *json = cJSON_CreateObject();
-    cJSON_AddStringToObject(json, "ssid", ssid);
-    cJSON_AddStringToObject(json, "pass", pass);
-
-    send_json_obj(req, json);
-    return ESP_OK;
+    char buf[JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_begin(req, &w, buf, sizeof(buf));
+    json_writer_kv_string(&w, "ssid", cfg.wifi_ssid);
+    json_writer_kv_string(&w, "pass", cfg.wifi_pass);
+    return json_end(req, &w);
 }
 
 /* ----------------- API: /api/config (POST) ----------------- */
@@ -85,8 +128,10 @@ static esp_err_t api_config_post_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
+    power_manager_section_begin(POWER_SECTION_JSON);
     cJSON *root = cJSON_Parse(body);
-    free(body);
+    power_manager_section_end(POWER_SECTION_JSON);
+    srv_free(body);
     if (!root) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
@@ -113,68 +158,613 @@ static esp_err_t api_config_post_handler(httpd_req_t *req)
     ESP_LOGI(TAG, "Saving config: SSID='%s' PASS len=%d, LAT:%f LON:%f", ssid, (int)strlen(pass),
              latitude, longitude);
 
-    // Store in NVS
-    nvs_manager_save_str("wifi_ssid", ssid);
-    nvs_manager_save_str("wifi_pass", pass);
-    nvs_manager_save_double("latitude", latitude);
-    nvs_manager_save_double("longitude", longitude);
-
-    cJSON *resp = cJSON_CreateObject();
-    cJSON_AddStringToObject(resp, "status", "ok");
-    cJSON_AddStringToObject(resp, "msg", "Config saved! Restarting...");
-    send_json_obj(req, resp);
+    if (strlen(ssid) >= APP_CONFIG_SSID_LEN || strlen(pass) >= APP_CONFIG_PASS_LEN) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "SSID or password too long");
+        return ESP_FAIL;
+    }
 
+    app_config_t cfg;
+    config_manager_get(&cfg);
+    strlcpy(cfg.wifi_ssid, ssid, sizeof(cfg.wifi_ssid));
+    strlcpy(cfg.wifi_pass, pass, sizeof(cfg.wifi_pass));
+    cfg.latitude = latitude;
+    cfg.longitude = longitude;
     cJSON_Delete(root);
 
-    /* Give client time to get response */
-    vTaskDelay(pdMS_TO_TICKS(800));
-    esp_restart();
-    return ESP_OK;
+    /* One NVS commit; subscribers apply the change live, no reboot */
+    if (config_manager_update(&cfg) != ESP_OK) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    char buf[JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_begin(req, &w, buf, sizeof(buf));
+    json_writer_kv_string(&w, "status", "ok");
+    json_writer_kv_string(&w, "msg", "Config saved and applied");
+    return json_end(req, &w);
 }
 
 /* ----------------- API: /api/status (GET) ----------------- */
 static esp_err_t api_status_get_handler(httpd_req_t *req)
 {
-    cJSON *root = cJSON_CreateObject();
-    if (!root) {
-        httpd_resp_send_500(req);
-        return ESP_FAIL;
-    }
-
     fw_info_t info;
     fw_info_load(&info);
 
-    cJSON_AddStringToObject(root, "fw_version", info.version);
-    cJSON_AddStringToObject(root, "fw_build_date", info.build_date);
-    cJSON_AddStringToObject(root, "chip_model", info.chip_model);
-    cJSON_AddNumberToObject(root, "flash_size_bytes", info.flash_size);
-    cJSON_AddNumberToObject(root, "chip_id", info.chip_id);
-
     char mac_str[18];  // 6 bytes -> "XX:XX:XX:XX:XX:XX"
     snprintf(mac_str, sizeof(mac_str), "%02X:%02X:%02X:%02X:%02X:%02X", info.mac_addr[0],
              info.mac_addr[1], info.mac_addr[2], info.mac_addr[3], info.mac_addr[4],
              info.mac_addr[5]);
-    cJSON_AddStringToObject(root, "mac_address", mac_str);
-    cJSON_AddNumberToObject(root, "free_heap", info.free_heap);
 
-    // Send JSON
-    char *s = cJSON_PrintUnformatted(root);
-    if (!s) {
-        cJSON_Delete(root);
+    http_server_cache_stats_t cs;
+    http_server_get_cache_stats(&cs);
+
+    char buf[JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_begin(req, &w, buf, sizeof(buf));
+    json_writer_kv_string(&w, "fw_version", info.version);
+    json_writer_kv_string(&w, "fw_build_date", info.build_date);
+    json_writer_kv_string(&w, "chip_model", info.chip_model);
+    json_writer_kv_uint(&w, "flash_size_bytes", info.flash_size);
+    json_writer_kv_uint(&w, "chip_id", info.chip_id);
+    json_writer_kv_string(&w, "mac_address", mac_str);
+    json_writer_kv_uint(&w, "chip_revision", info.chip_revision);
+    json_writer_kv_uint(&w, "chip_cores", info.chip_cores);
+    json_writer_kv_uint(&w, "free_heap", info.free_heap);
+    json_writer_kv_uint(&w, "min_free_heap", info.min_free_heap);
+#if !CONFIG_IDF_TARGET_LINUX
+    json_writer_kv_uint(&w, "largest_free_block", info.largest_free_block);
+#endif
+    json_writer_kv_uint(&w, "uptime_ms", info.uptime_ms);
+
+    json_writer_key(&w, "asset_cache");
+    json_writer_object_begin(&w);
+    json_writer_kv_uint(&w, "hits", cs.hits);
+    json_writer_kv_uint(&w, "misses", cs.misses);
+    json_writer_kv_uint(&w, "not_modified", cs.not_modified);
+    json_writer_kv_uint(&w, "entries", cs.entries);
+    json_writer_kv_uint(&w, "bytes", cs.bytes);
+    json_writer_object_end(&w);
+
+    const boot_phase_t *phases;
+    size_t phase_count = boot_timeline_get(&phases);
+    json_writer_key(&w, "boot");
+    json_writer_array_begin(&w);
+    for (size_t i = 0; i < phase_count; i++) {
+        json_writer_object_begin(&w);
+        json_writer_kv_string(&w, "phase", phases[i].name);
+        json_writer_kv_uint(&w, "t_us", phases[i].t_us);
+        json_writer_kv_uint(&w, "dt_us", phases[i].t_us - (i ? phases[i - 1].t_us : 0));
+        json_writer_object_end(&w);
+    }
+    json_writer_array_end(&w);
+
+    return json_end(req, &w);
+}
+
+/* ----------------- API: /api/tasks (GET) ----------------- */
+static esp_err_t api_tasks_get_handler(httpd_req_t *req)
+{
+    /* ~1 KB, too much for the httpd task stack */
+    fw_info_tasks_t *t = srv_malloc(sizeof(*t));
+    if (!t) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = fw_info_get_tasks(t);
+    if (err != ESP_OK) {
+        srv_free(t);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+
+    char buf[JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_begin(req, &w, buf, sizeof(buf));
+    json_writer_kv_uint(&w, "sample_ms", FW_INFO_TASK_SAMPLE_MS);
+    json_writer_kv_uint(&w, "window_ms", t->window_ms);
+
+    json_writer_key(&w, "cores");
+    json_writer_array_begin(&w);
+    for (int c = 0; c < t->core_count && c < FW_INFO_MAX_CORES; c++) {
+        json_writer_object_begin(&w);
+        json_writer_kv_double(&w, "cpu", t->core_short[c] / 10.0, 1);
+        json_writer_kv_double(&w, "cpu_window", t->core_window[c] / 10.0, 1);
+        json_writer_object_end(&w);
+    }
+    json_writer_array_end(&w);
+
+    json_writer_key(&w, "tasks");
+    json_writer_array_begin(&w);
+    for (size_t i = 0; i < t->task_count; i++) {
+        const fw_info_task_t *task = &t->tasks[i];
+        json_writer_object_begin(&w);
+        json_writer_kv_string(&w, "name", task->name);
+        json_writer_kv_uint(&w, "priority", task->priority);
+        json_writer_kv_uint(&w, "state", task->state);
+        json_writer_kv_int(&w, "core", task->core);
+        json_writer_kv_double(&w, "cpu", task->cpu_short / 10.0, 1);
+        json_writer_kv_double(&w, "cpu_window", task->cpu_window / 10.0, 1);
+        json_writer_kv_uint(&w, "stack_free", task->stack_free);
+        json_writer_object_end(&w);
+    }
+    json_writer_array_end(&w);
+
+    srv_free(t);
+    return json_end(req, &w);
+}
+
+/* ----------------- API: /api/trace (GET, Chrome Trace Event JSON) ----------------- */
+static esp_err_t api_trace_get_handler(httpd_req_t *req)
+{
+    char buf[JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_begin(req, &w, buf, sizeof(buf));
+    json_writer_kv_string(&w, "displayTimeUnit", "ms");
+    json_writer_key(&w, "traceEvents");
+    json_writer_array_begin(&w);
+    esp_err_t err = trace_write_chrome_events(&w);
+    json_writer_array_end(&w);
+    if (err == ESP_ERR_NOT_SUPPORTED)
+        ESP_LOGW(TAG, "Trace recorder disabled in menuconfig");
+    return json_end(req, &w);
+}
+
+/* ----------------- API: /api/heap (GET) ----------------- */
+static esp_err_t api_heap_get_handler(httpd_req_t *req)
+{
+    heap_sample_t *samples = srv_malloc(HEAP_MONITOR_SAMPLES * sizeof(heap_sample_t));
+    if (!samples) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    size_t n = heap_monitor_get_samples(samples, HEAP_MONITOR_SAMPLES);
+
+    char buf[JSON_CHUNK_SIZE];
+    json_writer_t w;
+    json_begin(req, &w, buf, sizeof(buf));
+
+    json_writer_key(&w, "modules");
+    json_writer_object_begin(&w);
+    for (int m = 0; m < HEAP_MODULE_COUNT; m++) {
+        heap_module_stats_t st;
+        heap_monitor_get_module(m, &st);
+        json_writer_key(&w, heap_monitor_module_name(m));
+        json_writer_object_begin(&w);
+        json_writer_kv_uint(&w, "allocs", st.allocs);
+        json_writer_kv_uint(&w, "frees", st.frees);
+        json_writer_kv_uint(&w, "live_bytes", st.live_bytes);
+        json_writer_kv_uint(&w, "peak_bytes", st.peak_bytes);
+        json_writer_kv_uint(&w, "total_bytes", st.total_bytes);
+        json_writer_object_end(&w);
+    }
+    json_writer_object_end(&w);
+
+    /* Fragmentation: share of the free heap that is not in the largest block. The linux
+       target only measures the free total, so the other fields are left out there. */
+    json_writer_kv_uint(&w, "sample_period_s", HEAP_MONITOR_SAMPLE_PERIOD_S);
+    json_writer_key(&w, "samples");
+    json_writer_array_begin(&w);
+    for (size_t i = 0; i < n; i++) {
+        const heap_sample_t *s = &samples[i];
+        json_writer_object_begin(&w);
+        json_writer_kv_uint(&w, "t", s->uptime_s);
+        json_writer_kv_uint(&w, "free", s->free_bytes);
+#if !CONFIG_IDF_TARGET_LINUX
+        json_writer_kv_uint(&w, "largest", s->largest_free);
+        json_writer_kv_uint(&w, "min", s->min_free);
+        json_writer_kv_double(&w, "frag",
+                              s->free_bytes ? 100.0 * (s->free_bytes - s->largest_free) /
+                                                  s->free_bytes
+                                            : 0.0,
+                              1);
+#endif
+        json_writer_object_end(&w);
+    }
+    json_writer_array_end(&w);
+
+    srv_free(samples);
+    return json_end(req, &w);
+}
+
+/* ----------------- API: /api/history (GET) ----------------- */
+/*
+ * /api/history?from=<unix>&to=<unix>&fmt=csv|bin
+ *
+ * Records are streamed straight from the mapped history partition with
+ * chunked transfer encoding; only one small batch buffer is held at a time.
+ * fmt=bin sends the raw 16-byte history_record_t records (little endian),
+ * fmt=csv (default) one text line per record.
+ */
+#define HISTORY_CHUNK_SIZE 1024
+
+typedef struct {
+    httpd_req_t *req;
+    bool binary;
+    esp_err_t err;
+    size_t len;
+    char buf[HISTORY_CHUNK_SIZE];
+} history_stream_t;
+
+static bool history_flush(history_stream_t *st)
+{
+    if (st->len > 0 && st->err == ESP_OK) {
+        st->err = httpd_resp_send_chunk(st->req, st->buf, st->len);
+        st->len = 0;
+    }
+    return st->err == ESP_OK;
+}
+
+/* Format a value stored in hundredths, e.g. -105 -> "-1.05" */
+static int format_x100(char *out, size_t max_len, int32_t v)
+{
+    uint32_t a = (v < 0) ? (uint32_t)(-v) : (uint32_t)v;
+    return snprintf(out, max_len, "%s%u.%02u", v < 0 ? "-" : "", (unsigned)(a / 100),
+                    (unsigned)(a % 100));
+}
+
+static bool history_visit(const history_record_t *rec, void *ctx)
+{
+    history_stream_t *st = ctx;
+
+    if (st->binary) {
+        if (st->len + sizeof(*rec) > sizeof(st->buf) && !history_flush(st))
+            return false;
+        memcpy(st->buf + st->len, rec, sizeof(*rec));
+        st->len += sizeof(*rec);
+        return true;
+    }
+
+    char t[12], h[12], p[12];
+    format_x100(t, sizeof(t), rec->temperature_x100);
+    format_x100(h, sizeof(h), rec->humidity_x100);
+    format_x100(p, sizeof(p), rec->precipitation_x100);
+
+    char line[80];
+    int n = snprintf(line, sizeof(line), "%u,%s,%s,%s,%u,%u\n", (unsigned)rec->timestamp, t, h,
+                     p, (unsigned)rec->weather_code,
+                     (rec->flags & HISTORY_FLAG_IS_DAY) ? 1u : 0u);
+    if (st->len + n > sizeof(st->buf) && !history_flush(st))
+        return false;
+    memcpy(st->buf + st->len, line, n);
+    st->len += n;
+    return true;
+}
+
+static esp_err_t api_history_get_handler(httpd_req_t *req)
+{
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    bool binary = false;
+
+    char query[96];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char val[16];
+        if (httpd_query_key_value(query, "from", val, sizeof(val)) == ESP_OK)
+            from = strtoul(val, NULL, 10);
+        if (httpd_query_key_value(query, "to", val, sizeof(val)) == ESP_OK)
+            to = strtoul(val, NULL, 10);
+        if (httpd_query_key_value(query, "fmt", val, sizeof(val)) == ESP_OK) {
+            if (strcmp(val, "bin") == 0) {
+                binary = true;
+            } else if (strcmp(val, "csv") != 0) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "fmt must be csv or bin");
+                return ESP_FAIL;
+            }
+        }
+    }
+    if (from > to) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "from is after to");
+        return ESP_FAIL;
+    }
+
+    history_stream_t *st = srv_malloc(sizeof(*st));
+    if (!st) {
         httpd_resp_send_500(req);
         return ESP_FAIL;
     }
+    st->req = req;
+    st->binary = binary;
+    st->err = ESP_OK;
+    st->len = 0;
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, s);
+    httpd_resp_set_type(req, binary ? "application/octet-stream" : "text/csv");
+    if (!binary) {
+        st->len = strlcpy(st->buf, "timestamp,temperature_c,humidity_pct,precipitation_mm,"
+                                   "weather_code,is_day\n", sizeof(st->buf));
+    }
 
-    free(s);
-    cJSON_Delete(root);
+    int64_t start = esp_timer_get_time();
+    size_t count = history_log_query(from, to, history_visit, st);
+    history_flush(st);
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    esp_err_t err = st->err;
+    srv_free(st);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "History export aborted: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+
+    ESP_LOGI(TAG, "History export: %u records (%s) in %lld ms, %llu records/s", (unsigned)count,
+             binary ? "bin" : "csv", (long long)(elapsed_us / 1000),
+             (unsigned long long)(elapsed_us > 0 ? count * 1000000ULL / elapsed_us : 0));
     return ESP_OK;
 }
 
 /* ----------------- File serving from LittleFS ----------------- */
-/* Uses fs_handler_read_file() which returns allocated buffer + size */
+/*
+ * Files are streamed in FILE_CHUNK_SIZE pieces with chunked transfer
+ * encoding. The chunk buffer lives in the per-connection session context,
+ * so it is allocated once per socket and freed by httpd when it closes;
+ * memory per request stays constant whatever the file size.
+ */
+#if !CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
+#define FILE_CHUNK_SIZE 1024
+
+typedef struct {
+    char chunk[FILE_CHUNK_SIZE];  ///< File streaming buffer
+} http_session_t;
+
+static http_session_t *get_session(httpd_req_t *req)
+{
+    if (!req->sess_ctx) {
+        req->sess_ctx = srv_malloc(sizeof(http_session_t));
+        req->free_ctx = srv_free;
+    }
+    return req->sess_ctx;
+}
+#endif  // !CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
+
+/* ----------------- Static asset cache ----------------- */
+/*
+ * Small assets are loaded into RAM once, when the server starts, together
+ * with a strong ETag (FNV-1a 64 of the body). Cached responses carry
+ * Cache-Control and ETag, and a matching If-None-Match gets a bodyless 304,
+ * so repeat portal visits cost no flash reads. The .gz twins are separate
+ * entries with their own ETag. Larger files are streamed from LittleFS.
+ *
+ * With CONFIG_HTTP_SERVER_ASSETS_EMBEDDED the entries instead point at the
+ * files linked into the app image, sent straight from mapped flash; the
+ * RAM size limits do not apply and nothing is streamed from LittleFS.
+ */
+#define ASSET_CACHE_MAX_ENTRIES 16
+#define ASSET_CACHE_MAX_FILE 8192
+#define ASSET_CACHE_BUDGET 32768
+
+/* The entry document is revalidated each time, sub-resources are kept a week */
+#define ASSET_CACHE_CONTROL "public, max-age=604800"
+#define ASSET_CACHE_CONTROL_HTML "no-cache"
+
+typedef struct {
+    char path[32];
+    char etag[20];  // "\"<16 hex>\""
+    const char *data;
+    size_t len;
+} cached_asset_t;
+
+static cached_asset_t asset_cache[ASSET_CACHE_MAX_ENTRIES];
+static size_t asset_cache_count = 0;
+static size_t asset_cache_bytes = 0;
+static http_server_cache_stats_t cache_stats;
+
+static uint64_t fnv1a64(const char *data, size_t len)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void asset_cache_insert(const char *path, const char *data, size_t len)
+{
+    if (asset_cache_count >= ASSET_CACHE_MAX_ENTRIES ||
+        strlen(path) >= sizeof(asset_cache[0].path)) {
+        ESP_LOGW(TAG, "Asset table full, skipping %s", path);
+        return;
+    }
+
+    cached_asset_t *a = &asset_cache[asset_cache_count++];
+    strlcpy(a->path, path, sizeof(a->path));
+    snprintf(a->etag, sizeof(a->etag), "\"%016llx\"", (unsigned long long)fnv1a64(data, len));
+    a->data = data;
+    a->len = len;
+}
+
+#if CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
+
+static void asset_cache_init(void)
+{
+    if (asset_cache_count > 0)
+        return;
+    for (size_t i = 0; i < embedded_asset_count; i++) {
+        const embedded_asset_t *e = &embedded_assets[i];
+        asset_cache_insert(e->path, (const char *)e->start, (size_t)(e->end - e->start));
+    }
+    ESP_LOGI(TAG, "Embedded assets: %u files", (unsigned)asset_cache_count);
+}
+
+#else
+
+static void asset_cache_add(const char *path, size_t size, void *ctx)
+{
+    if (size > ASSET_CACHE_MAX_FILE || asset_cache_bytes + size > ASSET_CACHE_BUDGET) {
+        ESP_LOGI(TAG, "Not caching %s (%u bytes)", path, (unsigned)size);
+        return;
+    }
+
+    char *buf = NULL;
+    size_t len = 0;
+    if (fs_handler_read_file(path, &buf, &len) != ESP_OK)
+        return;
+
+    size_t before = asset_cache_count;
+    asset_cache_insert(path, buf, len);
+    if (asset_cache_count == before) {
+        heap_monitor_free(HEAP_MODULE_FS, buf);
+        return;
+    }
+    asset_cache_bytes += len;
+}
+
+static void asset_cache_init(void)
+{
+    if (asset_cache_count > 0)
+        return;
+    fs_handler_for_each_file(asset_cache_add, NULL);
+    ESP_LOGI(TAG, "Asset cache: %u files, %u bytes", (unsigned)asset_cache_count,
+             (unsigned)asset_cache_bytes);
+}
+
+#endif  // CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
+
+/* Find the cached asset for path + suffix (suffix is "" or ".gz") */
+static const cached_asset_t *asset_cache_find(const char *path, const char *suffix)
+{
+    size_t plen = strlen(path);
+    for (size_t i = 0; i < asset_cache_count; i++) {
+        const char *p = asset_cache[i].path;
+        if (strncmp(p, path, plen) == 0 && strcmp(p + plen, suffix) == 0)
+            return &asset_cache[i];
+    }
+    return NULL;
+}
+
+static esp_err_t send_cached_asset(httpd_req_t *req, const cached_asset_t *a, bool is_html)
+{
+    cache_stats.hits++;
+    httpd_resp_set_hdr(req, "ETag", a->etag);
+    httpd_resp_set_hdr(req, "Cache-Control",
+                       is_html ? ASSET_CACHE_CONTROL_HTML : ASSET_CACHE_CONTROL);
+
+    char inm[64];
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm));
+    if ((err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC) && strstr(inm, a->etag)) {
+        cache_stats.not_modified++;
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    return httpd_resp_send(req, a->data, a->len);
+}
+
+void http_server_get_cache_stats(http_server_cache_stats_t *out)
+{
+    if (!out)
+        return;
+    *out = cache_stats;
+    out->entries = asset_cache_count;
+    out->bytes = asset_cache_bytes;
+}
+
+/* ----------------- MIME types ----------------- */
+/*
+ * Extension -> MIME table, sorted by extension for bsearch(). Only the
+ * extension of the last path segment counts, so "/foo.json.css" is CSS.
+ * `compressible` marks the types gzip_assets.py stores a .gz twin for.
+ */
+typedef struct {
+    const char *ext;
+    const char *type;
+    bool compressible;
+} mime_type_t;
+
+static const mime_type_t mime_html = { "html", "text/html", true };
+static const mime_type_t mime_default = { "", "application/octet-stream", false };
+
+static const mime_type_t mime_table[] = {
+    { "css", "text/css", true },
+    { "htm", "text/html", true },
+    { "html", "text/html", true },
+    { "ico", "image/x-icon", false },
+    { "js", "application/javascript", true },
+    { "json", "application/json", true },
+    { "png", "image/png", false },
+    { "svg", "image/svg+xml", true },
+    { "txt", "text/plain", true },
+    { "woff", "font/woff", false },
+    { "woff2", "font/woff2", false },
+};
+
+static int mime_cmp(const void *key, const void *elem)
+{
+    return strcasecmp((const char *)key, ((const mime_type_t *)elem)->ext);
+}
+
+static const mime_type_t *mime_lookup(const char *path)
+{
+    const char *name = strrchr(path, '/');
+    const char *dot = strrchr(name ? name : path, '.');
+    if (!dot)
+        return &mime_html;  // Extensionless pages ("/") are HTML
+
+    const mime_type_t *m = bsearch(dot + 1, mime_table, sizeof(mime_table) / sizeof(mime_table[0]),
+                                   sizeof(mime_table[0]), mime_cmp);
+    if (!m)
+        return &mime_default;
+    return (strcmp(m->type, "text/html") == 0) ? &mime_html : m;
+}
+
+/* True if the request's Accept-Encoding lists gzip */
+static bool client_accepts_gzip(httpd_req_t *req)
+{
+    char enc[64];
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept-Encoding", enc, sizeof(enc));
+    if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC)
+        return false;
+    return strstr(enc, "gzip") != NULL;
+}
+
+#if !CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
+/* Stream a LittleFS file (or its .gz twin) through the session chunk buffer */
+static esp_err_t stream_file(httpd_req_t *req, char *path, size_t path_size, bool gzip)
+{
+    http_session_t *sess = get_session(req);
+    if (!sess) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    FILE *f = NULL;
+    if (gzip) {
+        /* Try "<path>.gz" in place, then restore the plain path */
+        size_t len = strlen(path);
+        if (len + 3 < path_size) {
+            strcpy(path + len, ".gz");
+            f = fs_handler_open(path, NULL);
+            path[len] = '\0';
+            if (f)
+                httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        }
+    }
+    if (!f)
+        f = fs_handler_open(path, NULL);
+    if (!f) {
+        ESP_LOGW(TAG, "File not found: %s", path);
+        httpd_resp_send_404(req);
+        return ESP_FAIL;
+    }
+
+    size_t n;
+    while ((n = fs_handler_read_chunk(f, sess->chunk, sizeof(sess->chunk))) > 0) {
+        if (httpd_resp_send_chunk(req, sess->chunk, n) != ESP_OK) {
+            ESP_LOGW(TAG, "Client dropped while sending %s", path);
+            fs_handler_close(f);
+            return ESP_FAIL;
+        }
+    }
+    fs_handler_close(f);
+
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+#endif  // !CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
+
+
 static esp_err_t file_get_handler(httpd_req_t *req)
 {
     char path[512];
@@ -201,55 +791,278 @@ static esp_err_t file_get_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    /* Determine MIME */
-    if (strstr(path, ".css"))
-        httpd_resp_set_type(req, "text/css");
-    else if (strstr(path, ".js"))
-        httpd_resp_set_type(req, "application/javascript");
-    else if (strstr(path, ".png"))
-        httpd_resp_set_type(req, "image/png");
-    else
-        httpd_resp_set_type(req, "text/html");
+    /* Determine MIME; text assets have a pre-compressed .gz twin in the image */
+    const mime_type_t *mime = mime_lookup(path);
+    bool compressible = mime->compressible;
+    bool is_html = (mime == &mime_html);
+    httpd_resp_set_type(req, mime->type);
 
-    char *buf = NULL;
-    size_t size = 0;
-    esp_err_t r = fs_handler_read_file(path, &buf, &size);
-    if (r != ESP_OK || !buf) {
-        ESP_LOGW(TAG, "File not found: %s", path);
-        httpd_resp_send_404(req);
+    bool gzip = compressible && client_accepts_gzip(req);
+    if (compressible)
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+    /* RAM cache first */
+    const cached_asset_t *cached = gzip ? asset_cache_find(path, ".gz") : NULL;
+    if (cached) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    } else {
+        cached = asset_cache_find(path, "");
+    }
+    if (cached)
+        return send_cached_asset(req, cached, is_html);
+    cache_stats.misses++;
+
+#if CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
+    /* Every embedded file is in the table: a miss is a missing file */
+    ESP_LOGW(TAG, "File not found: %s", path);
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+#else
+    return stream_file(req, path, sizeof(path), gzip);
+#endif
+}
+
+/* ----------------- API: /api/events (GET, Server-Sent Events) ----------------- */
+/*
+ * Subscribers keep their socket open after the handler returns. Events are
+ * formatted once into a heap frame and handed to the server task with
+ * httpd_queue_work(), which sends the same bytes to every subscriber. All
+ * subscriber state is only touched from the server task, so no lock is
+ * needed. close_fn drops subscribers when httpd closes their socket.
+ */
+#define SSE_MAX_CLIENTS 4
+#define SSE_HEAP_SAMPLE_MS 2000
+#define SSE_HEAP_DELTA 1024  // Push heap again once it moved by this many bytes
+
+typedef struct {
+    http_server_event_t event;
+    size_t len;
+    char data[];
+} sse_frame_t;
+
+static const char *const sse_event_names[HTTP_SERVER_EVENT_COUNT] = {
+    [HTTP_SERVER_EVENT_WEATHER] = "weather",
+    [HTTP_SERVER_EVENT_WIFI] = "wifi",
+    [HTTP_SERVER_EVENT_HEAP] = "heap",
+};
+
+static int sse_fds[SSE_MAX_CLIENTS] = { -1, -1, -1, -1 };
+static volatile int sse_count = 0;
+static sse_frame_t *sse_last[HTTP_SERVER_EVENT_COUNT];  // Replayed to new subscribers
+static esp_timer_handle_t sse_heap_timer = NULL;
+static uint32_t sse_heap_free = 0;
+static uint32_t sse_heap_min = 0;
+
+static void sse_send(int fd, const char *data, size_t len)
+{
+    if (httpd_socket_send(server, fd, data, len, 0) < 0)
+        httpd_sess_trigger_close(server, fd);
+}
+
+/* Server task: dedupe, remember and broadcast one frame */
+static void sse_broadcast_work(void *arg)
+{
+    sse_frame_t *f = arg;
+    sse_frame_t *prev = sse_last[f->event];
+    if (prev && prev->len == f->len && memcmp(prev->data, f->data, f->len) == 0) {
+        srv_free(f);
+        return;
+    }
+    srv_free(prev);
+    sse_last[f->event] = f;
+
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (sse_fds[i] >= 0)
+            sse_send(sse_fds[i], f->data, f->len);
+    }
+}
+
+esp_err_t http_server_push_event(http_server_event_t event, const char *json)
+{
+    if (event >= HTTP_SERVER_EVENT_COUNT || !json)
+        return ESP_ERR_INVALID_ARG;
+    httpd_handle_t hd = server;
+    if (!hd)
+        return ESP_ERR_INVALID_STATE;
+
+    const char *name = sse_event_names[event];
+    size_t len = strlen("event: \ndata: \n\n") + strlen(name) + strlen(json);
+    sse_frame_t *f = srv_malloc(sizeof(*f) + len + 1);
+    if (!f)
+        return ESP_ERR_NO_MEM;
+    f->event = event;
+    f->len = snprintf(f->data, len + 1, "event: %s\ndata: %s\n\n", name, json);
+
+    esp_err_t err = httpd_queue_work(hd, sse_broadcast_work, f);
+    if (err != ESP_OK)
+        srv_free(f);
+    return err;
+}
+
+static void sse_heap_timer_cb(void *arg)
+{
+    uint32_t free_now = esp_get_free_heap_size();
+    uint32_t min_now = esp_get_minimum_free_heap_size();
+    uint32_t delta = (free_now > sse_heap_free) ? free_now - sse_heap_free
+                                                : sse_heap_free - free_now;
+    if (delta < SSE_HEAP_DELTA && min_now == sse_heap_min)
+        return;
+    sse_heap_free = free_now;
+    sse_heap_min = min_now;
+
+    char json[64];
+    snprintf(json, sizeof(json), "{\"free_heap\":%u,\"min_free_heap\":%u}", (unsigned)free_now,
+             (unsigned)min_now);
+    http_server_push_event(HTTP_SERVER_EVENT_HEAP, json);
+}
+
+static void sse_close_fn(httpd_handle_t hd, int fd)
+{
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (sse_fds[i] == fd) {
+            sse_fds[i] = -1;
+            if (--sse_count == 0 && sse_heap_timer)
+                esp_timer_stop(sse_heap_timer);
+            ESP_LOGI(TAG, "SSE subscriber %d left (%d active)", fd, sse_count);
+        }
+    }
+    close(fd);
+}
+
+static esp_err_t api_events_get_handler(httpd_req_t *req)
+{
+    int fd = httpd_req_to_sockfd(req);
+    int slot = -1;
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (sse_fds[i] < 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "Too many event subscribers");
+        return ESP_OK;
+    }
+
+    static const char headers[] = "HTTP/1.1 200 OK\r\n"
+                                  "Content-Type: text/event-stream\r\n"
+                                  "Cache-Control: no-cache\r\n"
+                                  "Connection: keep-alive\r\n\r\n";
+    if (httpd_socket_send(req->handle, fd, headers, sizeof(headers) - 1, 0) < 0)
         return ESP_FAIL;
+
+    sse_fds[slot] = fd;
+    sse_count++;
+    ESP_LOGI(TAG, "SSE subscriber %d joined (%d active)", fd, sse_count);
+
+    /* Current state first, then only changes */
+    for (int e = 0; e < HTTP_SERVER_EVENT_COUNT; e++) {
+        if (sse_last[e])
+            sse_send(fd, sse_last[e]->data, sse_last[e]->len);
     }
 
-    httpd_resp_send(req, buf, size);
-    free(buf);
+    if (sse_count == 1 && sse_heap_timer) {
+        sse_heap_free = 0;  // Force a fresh heap event
+        esp_timer_start_periodic(sse_heap_timer, (uint64_t)SSE_HEAP_SAMPLE_MS * 1000);
+    }
     return ESP_OK;
 }
 
-static esp_err_t root_get_handler(httpd_req_t *req)
+/* ----------------- /metrics (GET, Prometheus text format) ----------------- */
+static esp_err_t metrics_get_handler(httpd_req_t *req)
 {
-    httpd_resp_set_type(req, "text/html");
-    return file_get_handler(req);
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    if (metrics_write_prometheus(httpd_chunk_sink, req) != ESP_OK)
+        return ESP_FAIL;
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
-/* ----------------- URI mappings ----------------- */
-static const httpd_uri_t uri_api_status = {
-    .uri = "/api/status", .method = HTTP_GET, .handler = api_status_get_handler, .user_ctx = NULL
-};
+/* ----------------- Route table ----------------- */
+/*
+ * Exact API routes, sorted by (uri, method) and found with bsearch(), so
+ * dispatch does not depend on registration order. httpd only sees one wildcard
+ * handler per method; a GET that matches no route falls through to the
+ * static files.
+ */
+typedef struct {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *req);
+    bool portal;  // Only served in config mode
+} route_t;
 
-static const httpd_uri_t uri_api_get = {
-    .uri = "/api/config", .method = HTTP_GET, .handler = api_config_get_handler, .user_ctx = NULL
+static const route_t routes[] = {
+    { "/api/config", HTTP_GET, api_config_get_handler, true },
+    { "/api/config", HTTP_POST, api_config_post_handler, true },
+    { "/api/events", HTTP_GET, api_events_get_handler, false },
+    { "/api/heap", HTTP_GET, api_heap_get_handler, false },
+    { "/api/history", HTTP_GET, api_history_get_handler, false },
+    { "/api/status", HTTP_GET, api_status_get_handler, false },
+    { "/api/tasks", HTTP_GET, api_tasks_get_handler, false },
+    { "/api/trace", HTTP_GET, api_trace_get_handler, false },
+    { "/metrics", HTTP_GET, metrics_get_handler, false },
 };
 
-static const httpd_uri_t uri_api_post = {
-    .uri = "/api/config", .method = HTTP_POST, .handler = api_config_post_handler, .user_ctx = NULL
-};
+#define ROUTE_COUNT (sizeof(routes) / sizeof(routes[0]))
+
+typedef struct {
+    const char *uri;
+    size_t len;  // Path length, without the query string
+    int method;
+} route_key_t;
+
+static int route_cmp(const void *key, const void *elem)
+{
+    const route_key_t *k = key;
+    const route_t *r = elem;
+    int c = strncmp(k->uri, r->uri, k->len);
+    if (c == 0 && r->uri[k->len] != '\0')
+        c = -1;  // Key is a prefix of the route
+    if (c == 0)
+        c = k->method - (int)r->method;
+    return c;
+}
+
+static esp_err_t route_request(httpd_req_t *req)
+{
+    route_key_t key = { .uri = req->uri, .len = strcspn(req->uri, "?"), .method = req->method };
+    const route_t *r = bsearch(&key, routes, ROUTE_COUNT, sizeof(routes[0]), route_cmp);
+    if (r && (!r->portal || portal_enabled))
+        return r->handler(req);
+
+    /* Web UI files are part of the portal */
+    if (!r && req->method == HTTP_GET && portal_enabled)
+        return file_get_handler(req);
+
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+}
+
+/* Request-scoped cJSON arena; handlers run one at a time on the httpd task */
+#define REQUEST_JSON_ARENA_SIZE 2048
+static uint64_t request_arena_buf[REQUEST_JSON_ARENA_SIZE / sizeof(uint64_t)];
+static json_arena_t request_arena = JSON_ARENA_STATIC_INIT(request_arena_buf);
 
-static const httpd_uri_t uri_files = {
-    .uri = "/*", .method = HTTP_GET, .handler = file_get_handler, .user_ctx = NULL
+static esp_err_t dispatch_handler(httpd_req_t *req)
+{
+    int64_t start = esp_timer_get_time();
+    json_arena_bind(&request_arena);
+    esp_err_t err = route_request(req);
+    json_arena_bind(NULL);
+    json_arena_reset(&request_arena);
+    metrics_inc(METRIC_HTTP_REQUESTS);
+    metrics_observe_us(METRIC_HTTP_HANDLER_LATENCY, (uint32_t)(esp_timer_get_time() - start));
+    return err;
+}
+
+/* Catch-all registrations; routes[] decides what runs */
+static const httpd_uri_t uri_dispatch_get = {
+    .uri = "/*", .method = HTTP_GET, .handler = dispatch_handler, .user_ctx = NULL
 };
 
-static const httpd_uri_t uri_root = {
-    .uri = "/", .method = HTTP_GET, .handler = root_get_handler, .user_ctx = NULL
+static const httpd_uri_t uri_dispatch_post = {
+    .uri = "/*", .method = HTTP_POST, .handler = dispatch_handler, .user_ctx = NULL
 };
 
 /* ----------------- Server start / stop ----------------- */
@@ -260,6 +1073,7 @@ esp_err_t http_server_start(void)
         return ESP_OK;
     }
 
+#if !CONFIG_HTTP_SERVER_ASSETS_EMBEDDED
     /* ensure FS is mounted (safe to call multiple times) */
     esp_err_t fsret = fs_handler_init();
     if (fsret != ESP_OK) {
@@ -268,41 +1082,84 @@ esp_err_t http_server_start(void)
         /* We continue so that config endpoints still work even if FS empty.
            If you prefer to fail, return fsret here. */
     }
+#endif
+
+    asset_cache_init();
+
+    esp_err_t terr = fw_info_tasks_start();
+    if (terr != ESP_OK)
+        ESP_LOGW(TAG, "Task profiler unavailable: %s", esp_err_to_name(terr));
+
+    for (size_t i = 1; i < ROUTE_COUNT; i++) {
+        route_key_t k = { routes[i - 1].uri, strlen(routes[i - 1].uri), routes[i - 1].method };
+        if (route_cmp(&k, &routes[i]) >= 0)
+            ESP_LOGE(TAG, "routes[] not sorted at %s", routes[i].uri);
+    }
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_HTTP_SERVER_PORT;
     /* slightly larger recv timeout for bigger POSTs if needed */
     config.recv_wait_timeout = 2000;
 
     /* Instruct the server to use built-in wildcard matching logic */
     config.uri_match_fn = httpd_uri_match_wildcard;
 
+    /* Drop event subscribers when their socket closes */
+    config.close_fn = sse_close_fn;
+
+    if (!sse_heap_timer) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = sse_heap_timer_cb,
+            .name = "sse_heap",
+        };
+        esp_timer_create(&timer_args, &sse_heap_timer);
+    }
+
     esp_err_t err = httpd_start(&server, &config);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "httpd_start failed: %s", esp_err_to_name(err));
         return err;
     }
 
-    /* Register API + file handlers */
-    esp_err_t r = httpd_register_uri_handler(server, &uri_root);
-    ESP_LOGI(TAG, "Register / returned: %s", esp_err_to_name(r));
-    r = httpd_register_uri_handler(server, &uri_api_status);
-    ESP_LOGI(TAG, "Register /api/status GET returned: %s", esp_err_to_name(r));
-    r = httpd_register_uri_handler(server, &uri_api_get);
-    ESP_LOGI(TAG, "Register /api/config GET returned: %s", esp_err_to_name(r));
-    r = httpd_register_uri_handler(server, &uri_api_post);
-    ESP_LOGI(TAG, "Register /api/config POST returned: %s", esp_err_to_name(r));
-    r = httpd_register_uri_handler(server, &uri_files);
-    ESP_LOGI(TAG, "Register /* returned: %s", esp_err_to_name(r));
+    /* Register the dispatchers; API routes and files are resolved in dispatch_handler() */
+    esp_err_t r = httpd_register_uri_handler(server, &uri_dispatch_get);
+    ESP_LOGI(TAG, "Register /* GET returned: %s", esp_err_to_name(r));
+    r = httpd_register_uri_handler(server, &uri_dispatch_post);
+    ESP_LOGI(TAG, "Register /* POST returned: %s", esp_err_to_name(r));
 
     ESP_LOGI(TAG, "HTTP server started");
     return ESP_OK;
 }
 
+void http_server_set_portal(bool enabled)
+{
+    if (portal_enabled != enabled)
+        ESP_LOGI(TAG, "Config portal %s", enabled ? "enabled" : "disabled");
+    portal_enabled = enabled;
+}
+
 void http_server_stop(void)
 {
-    if (server) {
-        httpd_stop(server);
-        server = NULL;
-        ESP_LOGI(TAG, "HTTP server stopped");
+    if (!server)
+        return;
+
+    /* No more heap events, and pushes from other tasks see the server gone */
+    if (sse_heap_timer) {
+        esp_timer_stop(sse_heap_timer);
+        esp_timer_delete(sse_heap_timer);
+        sse_heap_timer = NULL;
+    }
+    httpd_handle_t hd = server;
+    server = NULL;
+    httpd_stop(hd);
+
+    /* The subscriber sockets and replay frames belong to the stopped server */
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++)
+        sse_fds[i] = -1;
+    sse_count = 0;
+    for (int e = 0; e < HTTP_SERVER_EVENT_COUNT; e++) {
+        srv_free(sse_last[e]);
+        sse_last[e] = NULL;
     }
+    ESP_LOGI(TAG, "HTTP server stopped");
 }
@@ -2,6 +2,8 @@
 #define HTTP_SERVER_H
 
 #include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,8 +15,32 @@ extern "C" {
  *
  * This module initializes and manages the internal HTTP server
  * responsible for serving configuration pages and REST API endpoints.
+ * The status, history and diagnostics endpoints are always served; the
+ * configuration portal (web UI files and /api/config) only while enabled
+ * with http_server_set_portal().
  */
 
+/**
+ * @brief Static asset cache counters.
+ */
+typedef struct {
+    uint32_t hits;          ///< Requests answered from the RAM cache
+    uint32_t misses;        ///< Requests streamed from LittleFS
+    uint32_t not_modified;  ///< Cache hits answered with 304 (no body)
+    uint32_t entries;       ///< Assets held in RAM
+    uint32_t bytes;         ///< RAM used by cached asset bodies
+} http_server_cache_stats_t;
+
+/**
+ * @brief Event streams pushed to /api/events (Server-Sent Events) subscribers.
+ */
+typedef enum {
+    HTTP_SERVER_EVENT_WEATHER = 0,  ///< New weather sample and fetch timing
+    HTTP_SERVER_EVENT_WIFI,         ///< Station link state
+    HTTP_SERVER_EVENT_HEAP,         ///< Free / minimum heap (sampled while subscribed)
+    HTTP_SERVER_EVENT_COUNT
+} http_server_event_t;
+
 /**
  * @brief Start the HTTP server.
  *
@@ -26,6 +52,16 @@ extern "C" {
  */
 esp_err_t http_server_start(void);
 
+/**
+ * @brief Expose or hide the configuration portal.
+ *
+ * While disabled, the web UI files and /api/config answer 404. May be called
+ * before the server is started.
+ *
+ * @param enabled true in configuration mode.
+ */
+void http_server_set_portal(bool enabled);
+
 /**
  * @brief Stop the HTTP server if currently running.
  *
@@ -33,6 +69,31 @@ esp_err_t http_server_start(void);
  */
 void http_server_stop(void);
 
+/**
+ * @brief Get the static asset cache counters.
+ *
+ * @param[out] out Structure to fill.
+ */
+void http_server_get_cache_stats(http_server_cache_stats_t *out);
+
+/**
+ * @brief Push an event to all /api/events subscribers.
+ *
+ * The SSE frame is formatted once and sent to every subscriber from the
+ * server task. A payload identical to the last one of the same event is
+ * dropped, and the last payload of each event is replayed to new
+ * subscribers. Safe to call from any task.
+ *
+ * @param event Event stream.
+ * @param json  Event payload (single-line JSON).
+ *
+ * @return
+ *  - ESP_OK if queued.
+ *  - ESP_ERR_INVALID_STATE if the server is not running.
+ *  - ESP_ERR_NO_MEM if the frame could not be allocated.
+ */
+esp_err_t http_server_push_event(http_server_event_t event, const char *json);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,81 @@
+#include "json_arena.h"
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+#include "heap_monitor.h"
+
+/* FreeRTOS thread-local slot holding the task's bound arena */
+#define JSON_ARENA_TLS_INDEX 1
+_Static_assert(configNUM_THREAD_LOCAL_STORAGE_POINTERS > JSON_ARENA_TLS_INDEX,
+               "CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS must be at least 2");
+
+#define JSON_ARENA_ALIGN 8  // cJSON nodes hold a double
+
+static inline json_arena_t *bound_arena(void)
+{
+    return pvTaskGetThreadLocalStoragePointer(NULL, JSON_ARENA_TLS_INDEX);
+}
+
+static inline bool arena_owns(const json_arena_t *arena, const void *ptr)
+{
+    const uint8_t *p = ptr;
+    return p >= arena->base && p < arena->base + arena->cap;
+}
+
+/* ----------------- Arena ----------------- */
+
+void json_arena_init(json_arena_t *arena, void *buf, size_t cap)
+{
+    *arena = (json_arena_t) { .base = buf, .cap = cap };
+}
+
+void *json_arena_alloc(json_arena_t *arena, size_t size)
+{
+    size_t start = (arena->used + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1);
+    if (size > arena->cap || start > arena->cap - size)
+        return NULL;
+
+    arena->used = start + size;
+    if (arena->used > arena->high_water)
+        arena->high_water = arena->used;
+    return arena->base + start;
+}
+
+void json_arena_reset(json_arena_t *arena)
+{
+    arena->used = 0;
+}
+
+void json_arena_bind(json_arena_t *arena)
+{
+    vTaskSetThreadLocalStoragePointer(NULL, JSON_ARENA_TLS_INDEX, arena);
+}
+
+/* ----------------- cJSON hooks ----------------- */
+
+static void *hook_malloc(size_t size)
+{
+    json_arena_t *arena = bound_arena();
+    if (arena) {
+        void *ptr = json_arena_alloc(arena, size);
+        if (ptr)
+            return ptr;
+        arena->overflows++;
+    }
+    return heap_monitor_malloc(HEAP_MODULE_JSON, size);
+}
+
+static void hook_free(void *ptr)
+{
+    json_arena_t *arena = bound_arena();
+    if (arena && arena_owns(arena, ptr))
+        return;  // Released by json_arena_reset()
+    heap_monitor_free(HEAP_MODULE_JSON, ptr);
+}
+
+void json_arena_install_hooks(void)
+{
+    cJSON_Hooks hooks = { .malloc_fn = hook_malloc, .free_fn = hook_free };
+    cJSON_InitHooks(&hooks);
+}
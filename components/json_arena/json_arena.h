@@ -0,0 +1,75 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file json_arena.h
+ * @brief Request-scoped bump arenas for cJSON.
+ *
+ * cJSON allocates through hooks installed by json_arena_install_hooks().
+ * While a task has an arena bound, its nodes and strings are carved from that
+ * arena with a pointer bump, and frees are no-ops. One json_arena_reset()
+ * then releases the whole tree in O(1). Other tasks, and allocations that do
+ * not fit, go to the heap (accounted to HEAP_MODULE_JSON).
+ *
+ * Trees built in an arena must be deleted (or dropped) before the arena is
+ * unbound or reset, and must not outlive the request.
+ */
+
+/**
+ * @brief Arena state. Use JSON_ARENA_STATIC_INIT() or json_arena_init().
+ */
+typedef struct {
+    uint8_t *base;
+    size_t cap;
+    size_t used;
+    size_t high_water;   ///< Largest `used` seen, across resets
+    uint32_t overflows;  ///< Allocations that did not fit and went to the heap
+} json_arena_t;
+
+/** Initializer for an arena over a static buffer. */
+#define JSON_ARENA_STATIC_INIT(buf) { (uint8_t *)(buf), sizeof(buf), 0, 0, 0 }
+
+/**
+ * @brief Route cJSON allocations through the arena hooks.
+ *
+ * Must run once before the first cJSON call.
+ */
+void json_arena_install_hooks(void);
+
+/**
+ * @brief Initialize an arena over a caller-provided buffer.
+ */
+void json_arena_init(json_arena_t *arena, void *buf, size_t cap);
+
+/**
+ * @brief Allocate from the arena (8-byte aligned).
+ *
+ * @return Pointer, or NULL if the arena is full.
+ */
+void *json_arena_alloc(json_arena_t *arena, size_t size);
+
+/**
+ * @brief Release everything allocated from the arena.
+ */
+void json_arena_reset(json_arena_t *arena);
+
+/**
+ * @brief Bind an arena to the calling task's cJSON allocations.
+ *
+ * @param arena Arena to use, or NULL to go back to the heap.
+ */
+void json_arena_bind(json_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // JSON_ARENA_H
@@ -0,0 +1,243 @@
+#include "json_writer.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+/* ----------------- Output ----------------- */
+
+static void flush(json_writer_t *w)
+{
+    if (w->err == ESP_OK && w->len > 0)
+        w->err = w->sink(w->sink_ctx, w->buf, w->len);
+    w->len = 0;
+}
+
+static void put(json_writer_t *w, const char *s, size_t n)
+{
+    while (n > 0 && w->err == ESP_OK) {
+        if (w->len == w->cap)
+            flush(w);
+        size_t room = w->cap - w->len;
+        size_t take = (n < room) ? n : room;
+        memcpy(w->buf + w->len, s, take);
+        w->len += take;
+        s += take;
+        n -= take;
+    }
+}
+
+static inline void put_char(json_writer_t *w, char c)
+{
+    put(w, &c, 1);
+}
+
+/* Comma handling: called before every value and key */
+static void begin_value(json_writer_t *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    uint32_t bit = 1u << w->depth;
+    if (w->has_items & bit)
+        put_char(w, ',');
+    w->has_items |= bit;
+}
+
+static void put_escaped(json_writer_t *w, const char *s)
+{
+    put_char(w, '"');
+    const char *run = s;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        put(w, run, s - run);
+        run = s + 1;
+
+        char esc[7];
+        switch (c) {
+            case '"':
+                put(w, "\\\"", 2);
+                break;
+            case '\\':
+                put(w, "\\\\", 2);
+                break;
+            case '\n':
+                put(w, "\\n", 2);
+                break;
+            case '\r':
+                put(w, "\\r", 2);
+                break;
+            case '\t':
+                put(w, "\\t", 2);
+                break;
+            default:
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                put(w, esc, 6);
+                break;
+        }
+    }
+    put(w, run, s - run);
+    put_char(w, '"');
+}
+
+static void open_scope(json_writer_t *w, char c)
+{
+    begin_value(w);
+    if (w->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        w->err = ESP_ERR_INVALID_SIZE;
+        return;
+    }
+    put_char(w, c);
+    w->depth++;
+    w->has_items &= ~(1u << w->depth);
+}
+
+static void close_scope(json_writer_t *w, char c)
+{
+    if (w->depth == 0) {
+        w->err = ESP_ERR_INVALID_STATE;
+        return;
+    }
+    w->depth--;
+    put_char(w, c);
+}
+
+/* ----------------- Public API ----------------- */
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap, json_writer_sink_t sink,
+                      void *ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->cap = cap;
+    w->sink = sink;
+    w->sink_ctx = ctx;
+    w->err = (buf && cap > 0 && sink) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void json_writer_object_begin(json_writer_t *w)
+{
+    open_scope(w, '{');
+}
+
+void json_writer_object_end(json_writer_t *w)
+{
+    close_scope(w, '}');
+}
+
+void json_writer_array_begin(json_writer_t *w)
+{
+    open_scope(w, '[');
+}
+
+void json_writer_array_end(json_writer_t *w)
+{
+    close_scope(w, ']');
+}
+
+void json_writer_key(json_writer_t *w, const char *key)
+{
+    begin_value(w);
+    put_escaped(w, key);
+    put_char(w, ':');
+    w->after_key = true;
+}
+
+void json_writer_string(json_writer_t *w, const char *value)
+{
+    if (!value) {
+        json_writer_null(w);
+        return;
+    }
+    begin_value(w);
+    put_escaped(w, value);
+}
+
+void json_writer_int(json_writer_t *w, int64_t value)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%" PRId64, value);
+    begin_value(w);
+    put(w, num, n);
+}
+
+void json_writer_uint(json_writer_t *w, uint64_t value)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%" PRIu64, value);
+    begin_value(w);
+    put(w, num, n);
+}
+
+void json_writer_bool(json_writer_t *w, bool value)
+{
+    begin_value(w);
+    if (value)
+        put(w, "true", 4);
+    else
+        put(w, "false", 5);
+}
+
+void json_writer_null(json_writer_t *w)
+{
+    begin_value(w);
+    put(w, "null", 4);
+}
+
+void json_writer_double(json_writer_t *w, double value, int decimals)
+{
+    if (!isfinite(value)) {
+        json_writer_null(w);
+        return;
+    }
+    char num[32];
+    int n = snprintf(num, sizeof(num), "%.*f", decimals, value);
+    if (n < 0 || n >= (int)sizeof(num)) {
+        json_writer_null(w);
+        return;
+    }
+    begin_value(w);
+    put(w, num, n);
+}
+
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value)
+{
+    json_writer_key(w, key);
+    json_writer_string(w, value);
+}
+
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value)
+{
+    json_writer_key(w, key);
+    json_writer_int(w, value);
+}
+
+void json_writer_kv_uint(json_writer_t *w, const char *key, uint64_t value)
+{
+    json_writer_key(w, key);
+    json_writer_uint(w, value);
+}
+
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value)
+{
+    json_writer_key(w, key);
+    json_writer_bool(w, value);
+}
+
+void json_writer_kv_double(json_writer_t *w, const char *key, double value, int decimals)
+{
+    json_writer_key(w, key);
+    json_writer_double(w, value, decimals);
+}
+
+esp_err_t json_writer_finish(json_writer_t *w)
+{
+    flush(w);
+    if (w->err == ESP_OK && w->depth != 0)
+        return ESP_ERR_INVALID_STATE;
+    return w->err;
+}
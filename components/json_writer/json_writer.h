@@ -0,0 +1,109 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file json_writer.h
+ * @brief Allocation-free streaming JSON writer.
+ *
+ * Output is formatted into a caller-provided buffer (usually on the stack)
+ * and handed to a sink callback whenever the buffer fills up, e.g.
+ * httpd_resp_send_chunk(). No heap is used and no document tree is built,
+ * so the cost is proportional to the bytes written.
+ *
+ * Errors are sticky: after a sink failure every call is a no-op and
+ * json_writer_finish() returns the error.
+ */
+
+/** Maximum nesting depth of objects and arrays. */
+#define JSON_WRITER_MAX_DEPTH 16
+
+/**
+ * @brief Output callback.
+ *
+ * @param ctx  User context given to json_writer_init().
+ * @param data Bytes to emit.
+ * @param len  Number of bytes.
+ *
+ * @return ESP_OK to continue, any other value aborts the document.
+ */
+typedef esp_err_t (*json_writer_sink_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Writer state. Treat as opaque; lives on the caller's stack.
+ */
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    json_writer_sink_t sink;
+    void *sink_ctx;
+    esp_err_t err;
+    uint8_t depth;
+    bool after_key;
+    uint32_t has_items;  ///< Bit n set once depth n holds an element (comma needed)
+} json_writer_t;
+
+/**
+ * @brief Initialize a writer.
+ *
+ * @param w     Writer to initialize.
+ * @param buf   Staging buffer (at least 16 bytes).
+ * @param cap   Buffer size in bytes.
+ * @param sink  Output callback.
+ * @param ctx   User context for the callback.
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t cap, json_writer_sink_t sink,
+                      void *ctx);
+
+void json_writer_object_begin(json_writer_t *w);
+void json_writer_object_end(json_writer_t *w);
+void json_writer_array_begin(json_writer_t *w);
+void json_writer_array_end(json_writer_t *w);
+
+/**
+ * @brief Write an object key; the next call writes its value.
+ */
+void json_writer_key(json_writer_t *w, const char *key);
+
+void json_writer_string(json_writer_t *w, const char *value);
+void json_writer_int(json_writer_t *w, int64_t value);
+void json_writer_uint(json_writer_t *w, uint64_t value);
+void json_writer_bool(json_writer_t *w, bool value);
+void json_writer_null(json_writer_t *w);
+
+/**
+ * @brief Write a number with a fixed number of decimals (NaN/Inf become null).
+ */
+void json_writer_double(json_writer_t *w, double value, int decimals);
+
+/* Key + value shorthands */
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value);
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value);
+void json_writer_kv_uint(json_writer_t *w, const char *key, uint64_t value);
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value);
+void json_writer_kv_double(json_writer_t *w, const char *key, double value, int decimals);
+
+/**
+ * @brief Flush buffered output to the sink.
+ *
+ * @return
+ *  - ESP_OK if the whole document reached the sink.
+ *  - ESP_ERR_INVALID_STATE if objects or arrays are still open.
+ *  - The first error returned by the sink otherwise.
+ */
+esp_err_t json_writer_finish(json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // JSON_WRITER_H
@@ -0,0 +1,179 @@
+#include "metrics.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+
+#define METRICS_PREFIX "esp32_"
+#define METRICS_MAX_BOUNDS 7
+#define METRICS_OUT_BUF 256
+
+/* --- Registry --- */
+
+typedef struct {
+    const char *name;
+    const char *help;
+} metric_desc_t;
+
+typedef struct {
+    const char *name;
+    const char *help;
+    uint32_t unit_us;                     ///< Storage unit of bounds and sum, in µs
+    uint32_t bounds[METRICS_MAX_BOUNDS];  ///< Upper bucket bounds, ascending
+} histogram_desc_t;
+
+static const metric_desc_t counter_desc[METRIC_COUNTER_COUNT] = {
+    [METRIC_WEATHER_FETCH_TOTAL] = { "weather_fetch_total", "Weather fetch attempts" },
+    [METRIC_WEATHER_FETCH_FAILED] = { "weather_fetch_failed_total", "Failed weather fetches" },
+    [METRIC_WEATHER_FETCH_RETRIES] = { "weather_fetch_retries_total", "Weather fetch retries" },
+    [METRIC_WIFI_RECONNECTS] = { "wifi_reconnects_total", "Station links re-established" },
+    [METRIC_HTTP_REQUESTS] = { "http_requests_total", "HTTP requests dispatched" },
+};
+
+static const metric_desc_t gauge_desc[METRIC_GAUGE_COUNT] = {
+    [METRIC_HEAP_FREE] = { "heap_free_bytes", "Free heap" },
+    [METRIC_HEAP_MIN_FREE] = { "heap_min_free_bytes", "Minimum free heap since boot" },
+    [METRIC_HEAP_LARGEST_FREE] = { "heap_largest_free_block_bytes", "Largest free heap block" },
+    [METRIC_WIFI_RSSI] = { "wifi_rssi_dbm", "Last station RSSI" },
+};
+
+/* Slow operations are stored in ms, fast ones in µs, so 32-bit sums do not wrap */
+static const histogram_desc_t histogram_desc[METRIC_HISTOGRAM_COUNT] = {
+    [METRIC_WEATHER_FETCH_LATENCY] = { "weather_fetch_seconds", "Weather fetch latency", 1000,
+                                       { 100, 250, 500, 1000, 2500, 5000, 10000 } },
+    [METRIC_WEATHER_PARSE_TIME] = { "weather_parse_seconds", "Weather JSON parse time", 1,
+                                    { 500, 1000, 2500, 5000, 10000, 25000, 50000 } },
+    [METRIC_DISPLAY_REFRESH_TIME] = { "display_refresh_seconds", "Display I2C refresh time", 1,
+                                      { 1000, 2500, 5000, 10000, 25000, 50000, 100000 } },
+    [METRIC_HTTP_HANDLER_LATENCY] = { "http_handler_seconds", "HTTP handler latency", 1,
+                                      { 1000, 5000, 10000, 50000, 100000, 500000, 1000000 } },
+};
+
+typedef struct {
+    atomic_uint_fast32_t buckets[METRICS_MAX_BOUNDS + 1];  ///< Per bucket, last is +Inf
+    atomic_uint_fast32_t sum;                              ///< In the histogram's unit
+} histogram_t;
+
+static atomic_uint_fast32_t counters[METRIC_COUNTER_COUNT];
+static atomic_int_fast32_t gauges[METRIC_GAUGE_COUNT];
+static histogram_t histograms[METRIC_HISTOGRAM_COUNT];
+
+/* --- Updates --- */
+
+void metrics_add(metrics_counter_t id, uint32_t n)
+{
+    if (id < METRIC_COUNTER_COUNT)
+        atomic_fetch_add_explicit(&counters[id], n, memory_order_relaxed);
+}
+
+void metrics_gauge_set(metrics_gauge_t id, int32_t value)
+{
+    if (id < METRIC_GAUGE_COUNT)
+        atomic_store_explicit(&gauges[id], value, memory_order_relaxed);
+}
+
+void metrics_observe_us(metrics_histogram_t id, uint32_t us)
+{
+    if (id >= METRIC_HISTOGRAM_COUNT)
+        return;
+
+    const histogram_desc_t *d = &histogram_desc[id];
+    uint32_t v = us / d->unit_us;
+    size_t b = 0;
+    while (b < METRICS_MAX_BOUNDS && v > d->bounds[b])
+        b++;
+
+    histogram_t *h = &histograms[id];
+    atomic_fetch_add_explicit(&h->buckets[b], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, v, memory_order_relaxed);
+}
+
+/* --- Prometheus text export --- */
+
+typedef struct {
+    char buf[METRICS_OUT_BUF];
+    size_t len;
+    metrics_sink_t sink;
+    void *ctx;
+    esp_err_t err;
+} out_t;
+
+static void out_flush(out_t *o)
+{
+    if (o->err == ESP_OK && o->len > 0)
+        o->err = o->sink(o->ctx, o->buf, o->len);
+    o->len = 0;
+}
+
+static void out_printf(out_t *o, const char *fmt, ...)
+{
+    for (int attempt = 0; attempt < 2 && o->err == ESP_OK; attempt++) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(o->buf + o->len, sizeof(o->buf) - o->len, fmt, ap);
+        va_end(ap);
+        if (n >= 0 && (size_t)n < sizeof(o->buf) - o->len) {
+            o->len += n;
+            return;
+        }
+        out_flush(o);  // Did not fit: flush and retry into an empty buffer
+    }
+}
+
+static void out_header(out_t *o, const char *name, const char *help, const char *type)
+{
+    out_printf(o, "# HELP " METRICS_PREFIX "%s %s\n# TYPE " METRICS_PREFIX "%s %s\n", name, help,
+               name, type);
+}
+
+esp_err_t metrics_write_prometheus(metrics_sink_t sink, void *ctx)
+{
+    if (!sink)
+        return ESP_ERR_INVALID_ARG;
+
+    metrics_gauge_set(METRIC_HEAP_FREE, (int32_t)esp_get_free_heap_size());
+    metrics_gauge_set(METRIC_HEAP_MIN_FREE, (int32_t)esp_get_minimum_free_heap_size());
+#if !CONFIG_IDF_TARGET_LINUX
+    metrics_gauge_set(METRIC_HEAP_LARGEST_FREE,
+                      (int32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+#endif
+
+    out_t o = { .len = 0, .sink = sink, .ctx = ctx, .err = ESP_OK };
+
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        out_header(&o, counter_desc[i].name, counter_desc[i].help, "counter");
+        out_printf(&o, METRICS_PREFIX "%s %u\n", counter_desc[i].name,
+                   (unsigned)atomic_load_explicit(&counters[i], memory_order_relaxed));
+    }
+
+    for (int i = 0; i < METRIC_GAUGE_COUNT; i++) {
+        out_header(&o, gauge_desc[i].name, gauge_desc[i].help, "gauge");
+        out_printf(&o, METRICS_PREFIX "%s %d\n", gauge_desc[i].name,
+                   (int)atomic_load_explicit(&gauges[i], memory_order_relaxed));
+    }
+
+    for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        const histogram_desc_t *d = &histogram_desc[i];
+        histogram_t *h = &histograms[i];
+        double unit_s = d->unit_us / 1e6;
+
+        out_header(&o, d->name, d->help, "histogram");
+        uint32_t cumulative = 0;
+        for (int b = 0; b < METRICS_MAX_BOUNDS; b++) {
+            cumulative += atomic_load_explicit(&h->buckets[b], memory_order_relaxed);
+            out_printf(&o, METRICS_PREFIX "%s_bucket{le=\"%g\"} %u\n", d->name,
+                       d->bounds[b] * unit_s, (unsigned)cumulative);
+        }
+        cumulative += atomic_load_explicit(&h->buckets[METRICS_MAX_BOUNDS], memory_order_relaxed);
+        out_printf(&o, METRICS_PREFIX "%s_bucket{le=\"+Inf\"} %u\n", d->name,
+                   (unsigned)cumulative);
+        out_printf(&o, METRICS_PREFIX "%s_sum %.6f\n", d->name,
+                   atomic_load_explicit(&h->sum, memory_order_relaxed) * unit_s);
+        out_printf(&o, METRICS_PREFIX "%s_count %u\n", d->name, (unsigned)cumulative);
+    }
+
+    out_flush(&o);
+    return o.err;
+}
@@ -0,0 +1,100 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file metrics.h
+ * @brief Lock-free runtime metrics with Prometheus text export.
+ *
+ * A fixed registry of counters, gauges and fixed-bucket histograms. Every
+ * update is a single 32-bit atomic operation, so any task (or ISR-free
+ * callback) can record without taking a lock. metrics_write_prometheus()
+ * renders the registry in the Prometheus text exposition format.
+ */
+
+/** Monotonic counters. */
+typedef enum {
+    METRIC_WEATHER_FETCH_TOTAL = 0,  ///< Weather fetch attempts
+    METRIC_WEATHER_FETCH_FAILED,     ///< Failed weather fetches
+    METRIC_WEATHER_FETCH_RETRIES,    ///< Extra HTTP attempts after a retryable failure
+    METRIC_WIFI_RECONNECTS,          ///< Station links re-established after a drop
+    METRIC_HTTP_REQUESTS,            ///< HTTP requests dispatched
+    METRIC_COUNTER_COUNT
+} metrics_counter_t;
+
+/** Point-in-time values. */
+typedef enum {
+    METRIC_HEAP_FREE = 0,      ///< Free heap in bytes (sampled on export)
+    METRIC_HEAP_MIN_FREE,      ///< Minimum free heap since boot (sampled on export)
+    METRIC_HEAP_LARGEST_FREE,  ///< Largest allocatable block (sampled on export)
+    METRIC_WIFI_RSSI,          ///< Last known station RSSI in dBm
+    METRIC_GAUGE_COUNT
+} metrics_gauge_t;
+
+/** Latency distributions. */
+typedef enum {
+    METRIC_WEATHER_FETCH_LATENCY = 0,  ///< Whole fetch: HTTPS request and parse
+    METRIC_WEATHER_PARSE_TIME,         ///< JSON parse of the API response
+    METRIC_DISPLAY_REFRESH_TIME,       ///< I2C frame transfer to the panel
+    METRIC_HTTP_HANDLER_LATENCY,       ///< HTTP server handler run time
+    METRIC_HISTOGRAM_COUNT
+} metrics_histogram_t;
+
+/**
+ * @brief Output callback for metrics_write_prometheus().
+ *
+ * @return ESP_OK to continue, any other value aborts the export.
+ */
+typedef esp_err_t (*metrics_sink_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Add to a counter.
+ */
+void metrics_add(metrics_counter_t id, uint32_t n);
+
+/**
+ * @brief Increment a counter by one.
+ */
+static inline void metrics_inc(metrics_counter_t id)
+{
+    metrics_add(id, 1);
+}
+
+/**
+ * @brief Set a gauge.
+ */
+void metrics_gauge_set(metrics_gauge_t id, int32_t value);
+
+/**
+ * @brief Record one observation in a histogram.
+ *
+ * @param id Histogram.
+ * @param us Observed duration in microseconds.
+ */
+void metrics_observe_us(metrics_histogram_t id, uint32_t us);
+
+/**
+ * @brief Render all metrics in Prometheus text format.
+ *
+ * Heap gauges are sampled right before rendering. Output goes through a
+ * small internal buffer to the sink, nothing is allocated.
+ *
+ * @param sink Output callback.
+ * @param ctx  User context passed to the sink.
+ *
+ * @return ESP_OK, or the first error returned by the sink.
+ */
+esp_err_t metrics_write_prometheus(metrics_sink_t sink, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // METRICS_H
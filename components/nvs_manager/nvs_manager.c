@@ -94,6 +94,100 @@ esp_err_t nvs_manager_read_double(const char *key, double *out_value)
     return err;
 }
 
+esp_err_t nvs_manager_save_batch(const nvs_manager_entry_t *entries, size_t count)
+{
+    if (!entries && count > 0)
+        return ESP_ERR_INVALID_ARG;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open("nvs", NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS for write: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    for (size_t i = 0; i < count && err == ESP_OK; i++) {
+        const nvs_manager_entry_t *e = &entries[i];
+        if (e->type == NVS_MANAGER_TYPE_STR)
+            err = nvs_set_str(handle, e->key, (const char *)e->value);
+        else if (e->type == NVS_MANAGER_TYPE_BLOB)
+            err = nvs_set_blob(handle, e->key, e->value, e->len);
+        else
+            err = nvs_set_blob(handle, e->key, e->value, sizeof(double));
+    }
+
+    /* One commit for the whole batch */
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+
+    if (err == ESP_OK)
+        ESP_LOGI(TAG, "Saved %u keys in one commit", (unsigned)count);
+    else
+        ESP_LOGE(TAG, "Batch save failed: %s", esp_err_to_name(err));
+
+    return err;
+}
+
+esp_err_t nvs_manager_read_batch(nvs_manager_entry_t *entries, size_t count, size_t *found)
+{
+    if (found)
+        *found = 0;
+    if (!entries && count > 0)
+        return ESP_ERR_INVALID_ARG;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open("nvs", NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        /* BLOB lengths double as "was read" markers, none was */
+        for (size_t i = 0; i < count; i++) {
+            if (entries[i].type == NVS_MANAGER_TYPE_BLOB)
+                entries[i].len = 0;
+        }
+        return err;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        nvs_manager_entry_t *e = &entries[i];
+        esp_err_t r;
+        if (e->type == NVS_MANAGER_TYPE_STR) {
+            size_t len = e->len;
+            r = nvs_get_str(handle, e->key, (char *)e->value, &len);
+        } else if (e->type == NVS_MANAGER_TYPE_BLOB) {
+            size_t len = e->len;
+            r = nvs_get_blob(handle, e->key, e->value, &len);
+            e->len = (r == ESP_OK) ? len : 0;
+        } else {
+            size_t size = sizeof(double);
+            r = nvs_get_blob(handle, e->key, e->value, &size);
+        }
+        if (r == ESP_OK && found)
+            (*found)++;
+    }
+
+    nvs_close(handle);
+    return ESP_OK;
+}
+
+esp_err_t nvs_manager_erase_keys(const char *const *keys, size_t count)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open("nvs", NVS_READWRITE, &handle);
+    if (err != ESP_OK)
+        return err;
+
+    for (size_t i = 0; i < count && err == ESP_OK; i++) {
+        err = nvs_erase_key(handle, keys[i]);
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+            err = ESP_OK;
+    }
+
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+    return err;
+}
+
 esp_err_t nvs_manager_erase_all(void)
 {
     nvs_handle_t handle;
@@ -2,6 +2,7 @@
 #define NVS_MANAGER_H
 
 #include "esp_err.h"
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,6 +16,25 @@ extern "C" {
  * configuration parameters stored in NVS.
  */
 
+/**
+ * @brief Value type of a batch entry.
+ */
+typedef enum {
+    NVS_MANAGER_TYPE_STR,     ///< Null-terminated string, `value` points to a char buffer
+    NVS_MANAGER_TYPE_DOUBLE,  ///< `value` points to a double (stored as blob)
+    NVS_MANAGER_TYPE_BLOB,    ///< `value` points to `len` bytes of binary data
+} nvs_manager_type_t;
+
+/**
+ * @brief One key of a batched read or write.
+ */
+typedef struct {
+    const char *key;          ///< Null-terminated key identifier
+    nvs_manager_type_t type;  ///< Value type
+    void *value;              ///< Source (save) or destination (read) of the value
+    size_t len;               ///< STR/BLOB buffer size; BLOB reads update it to the stored size
+} nvs_manager_entry_t;
+
 /**
  * @brief Initialize NVS storage subsystem.
  *
@@ -77,6 +97,54 @@ esp_err_t nvs_manager_save_double(const char *key, double value);
  */
 esp_err_t nvs_manager_read_double(const char *key, double *out_value);
 
+/**
+ * @brief Save several keys with a single NVS handle and a single commit.
+ *
+ * Not atomic: NVS stores each value as it is set, nvs_commit() only
+ * flushes what is still pending. If an entry fails, the entries before it
+ * stay stored and the ones after it are not written. Data that must change
+ * as a whole belongs in a single BLOB entry.
+ *
+ * @param entries    Keys and values to store.
+ * @param count      Number of entries.
+ *
+ * @return
+ *  - ESP_OK on success.
+ *  - esp_err_t error code of the first failing operation.
+ */
+esp_err_t nvs_manager_save_batch(const nvs_manager_entry_t *entries, size_t count);
+
+/**
+ * @brief Read several keys with a single NVS handle.
+ *
+ * Keys that do not exist (or do not fit their buffer) are skipped and their
+ * destination left untouched, so destinations can be pre-filled with defaults.
+ * For skipped BLOB entries `len` is set to 0, also when the namespace cannot
+ * be opened.
+ *
+ * @param entries    Keys and destinations.
+ * @param count      Number of entries.
+ * @param[out] found Optional, receives the number of keys actually read.
+ *
+ * @return
+ *  - ESP_OK if the namespace could be opened (even if keys are missing).
+ *  - ESP_ERR_NVS_NOT_FOUND if nothing was ever written to the namespace.
+ *  - esp_err_t on other failures.
+ */
+esp_err_t nvs_manager_read_batch(nvs_manager_entry_t *entries, size_t count, size_t *found);
+
+/**
+ * @brief Erase several keys with a single commit. Missing keys are ignored.
+ *
+ * @param keys   Array of null-terminated key identifiers.
+ * @param count  Number of keys.
+ *
+ * @return
+ *  - ESP_OK on success.
+ *  - esp_err_t on failure.
+ */
+esp_err_t nvs_manager_erase_keys(const char *const *keys, size_t count);
+
 /**
  * @brief Erase all NVS keys in the default namespace.
  *
@@ -0,0 +1,224 @@
+#include "power_manager.h"
+#include "sdkconfig.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_sleep.h"
+#include "esp_pm.h"
+#endif
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+
+static const char *TAG = "POWER_MANAGER";
+
+/* --- Hot sections (guarded by section_lock) --- */
+/* The host build (linux target) has no esp_pm or sleep: sections are only timed */
+typedef struct {
+#if !CONFIG_IDF_TARGET_LINUX
+    esp_pm_lock_handle_t cpu_lock;
+    esp_pm_lock_handle_t no_sleep_lock;
+#endif
+    uint32_t depth;
+    int64_t entered_at_us;
+    power_section_stats_t stats;
+} section_t;
+
+static const char *const section_names[POWER_SECTION_COUNT] = {
+    [POWER_SECTION_TLS] = "tls",
+    [POWER_SECTION_JSON] = "json",
+    [POWER_SECTION_I2C] = "i2c",
+};
+
+static portMUX_TYPE section_lock = portMUX_INITIALIZER_UNLOCKED;
+static section_t sections[POWER_SECTION_COUNT];
+
+/* Marks the RTC block as initialized (RTC RAM holds garbage after power-on) */
+#define RTC_STATS_MAGIC 0x50574D31  // "PWM1"
+
+static RTC_DATA_ATTR uint32_t rtc_magic;
+static RTC_DATA_ATTR power_manager_stats_t rtc_stats;
+static bool display_marked = false;
+
+esp_err_t power_manager_init(void)
+{
+    /* Locks are created even without CONFIG_PM_ENABLE: esp_pm then returns
+       ESP_ERR_NOT_SUPPORTED and the handles stay NULL (acquire is skipped). */
+#if !CONFIG_IDF_TARGET_LINUX
+    for (int i = 0; i < POWER_SECTION_COUNT; i++) {
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, section_names[i], &sections[i].cpu_lock);
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, section_names[i], &sections[i].no_sleep_lock);
+    }
+#endif
+
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+#ifdef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "DFS %d-%d MHz, light sleep %s", pm_config.min_freq_mhz, pm_config.max_freq_mhz,
+             pm_config.light_sleep_enable ? "on" : "off");
+    return ESP_OK;
+#else
+    ESP_LOGW(TAG, "Built without CONFIG_PM_ENABLE, running at fixed clock");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void power_manager_section_begin(power_section_t section)
+{
+    if (section >= POWER_SECTION_COUNT)
+        return;
+
+    section_t *s = &sections[section];
+#if !CONFIG_IDF_TARGET_LINUX
+    if (s->cpu_lock)
+        esp_pm_lock_acquire(s->cpu_lock);
+    if (s->no_sleep_lock)
+        esp_pm_lock_acquire(s->no_sleep_lock);
+#endif
+
+    portENTER_CRITICAL(&section_lock);
+    if (s->depth++ == 0)
+        s->entered_at_us = esp_timer_get_time();
+    s->stats.enter_count++;
+    portEXIT_CRITICAL(&section_lock);
+}
+
+void power_manager_section_end(power_section_t section)
+{
+    if (section >= POWER_SECTION_COUNT)
+        return;
+
+    section_t *s = &sections[section];
+
+    portENTER_CRITICAL(&section_lock);
+    if (s->depth > 0 && --s->depth == 0) {
+        uint32_t held_us = (uint32_t)(esp_timer_get_time() - s->entered_at_us);
+        s->stats.total_us += held_us;
+        if (held_us > s->stats.max_us)
+            s->stats.max_us = held_us;
+    }
+    portEXIT_CRITICAL(&section_lock);
+
+#if !CONFIG_IDF_TARGET_LINUX
+    if (s->no_sleep_lock)
+        esp_pm_lock_release(s->no_sleep_lock);
+    if (s->cpu_lock)
+        esp_pm_lock_release(s->cpu_lock);
+#endif
+}
+
+void power_manager_get_section_stats(power_section_stats_t out[POWER_SECTION_COUNT])
+{
+    portENTER_CRITICAL(&section_lock);
+    for (int i = 0; i < POWER_SECTION_COUNT; i++) {
+        out[i] = sections[i].stats;
+    }
+    portEXIT_CRITICAL(&section_lock);
+}
+
+const char *power_manager_section_name(power_section_t section)
+{
+    return (section < POWER_SECTION_COUNT) ? section_names[section] : "unknown";
+}
+
+void power_manager_dump_residency(void)
+{
+    power_section_stats_t stats[POWER_SECTION_COUNT];
+    power_manager_get_section_stats(stats);
+
+    uint64_t uptime_us = (uint64_t)esp_timer_get_time();
+    for (int i = 0; i < POWER_SECTION_COUNT; i++) {
+        ESP_LOGI(TAG, "section %-4s: %u entries, %llu us total (%.2f%%), max %u us",
+                 section_names[i], (unsigned)stats[i].enter_count,
+                 (unsigned long long)stats[i].total_us,
+                 uptime_us ? 100.0 * stats[i].total_us / uptime_us : 0.0,
+                 (unsigned)stats[i].max_us);
+    }
+
+#ifdef CONFIG_PM_PROFILING
+    /* Per power mode residency (CPU_MAX / APB_MAX / APB_MIN / LIGHT_SLEEP) */
+    esp_pm_dump_locks(stdout);
+#endif
+}
+
+/* Reset the retained block after a cold boot */
+static void ensure_rtc_stats(void)
+{
+    if (rtc_magic != RTC_STATS_MAGIC) {
+        rtc_stats = (power_manager_stats_t) { 0 };
+        rtc_magic = RTC_STATS_MAGIC;
+    }
+}
+
+bool power_manager_deep_sleep_enabled(void)
+{
+#ifdef CONFIG_POWER_DEEP_SLEEP_MODE
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool power_manager_woke_from_sleep(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return false;
+#else
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER && rtc_magic == RTC_STATS_MAGIC;
+#endif
+}
+
+void power_manager_mark_display_ready(void)
+{
+    if (display_marked)
+        return;
+    display_marked = true;
+
+    ensure_rtc_stats();
+    /* esp_timer starts counting at its init, after the ROM and bootloader have run */
+    rtc_stats.last_wake_to_display_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    ESP_LOGI(TAG, "Wake to display: %u ms", (unsigned)rtc_stats.last_wake_to_display_ms);
+}
+
+void power_manager_deep_sleep(uint32_t sleep_ms)
+{
+    ensure_rtc_stats();
+
+    uint32_t awake_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    rtc_stats.cycle_count++;
+    rtc_stats.last_awake_ms = awake_ms;
+    rtc_stats.total_awake_ms += awake_ms;
+    rtc_stats.total_sleep_ms += sleep_ms;
+
+    ESP_LOGI(TAG, "Cycle %u: awake %u ms (wake→display %u ms), sleeping %u ms",
+             (unsigned)rtc_stats.cycle_count, (unsigned)awake_ms,
+             (unsigned)rtc_stats.last_wake_to_display_ms, (unsigned)sleep_ms);
+
+#if CONFIG_IDF_TARGET_LINUX
+    vTaskDelay(pdMS_TO_TICKS(sleep_ms));
+#else
+    esp_sleep_enable_timer_wakeup((uint64_t)sleep_ms * 1000);
+    esp_deep_sleep_start();
+#endif
+}
+
+void power_manager_get_stats(power_manager_stats_t *out)
+{
+    if (!out)
+        return;
+
+    ensure_rtc_stats();
+    *out = rtc_stats;
+}
@@ -0,0 +1,143 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file power_manager.h
+ * @brief Sleep control and duty-cycle statistics.
+ *
+ * This module puts the device into deep sleep between scheduled weather
+ * fetches (when CONFIG_POWER_DEEP_SLEEP_MODE is enabled) and keeps per-cycle
+ * timing statistics in RTC memory so they survive the sleep.
+ *
+ * While awake it enables dynamic frequency scaling with automatic light
+ * sleep. CPU-intensive or timing-sensitive code runs inside a "hot section"
+ * that holds the CPU at full clock and blocks light sleep only for its
+ * duration.
+ */
+
+/**
+ * @brief Hot sections that need full CPU clock and no light sleep.
+ */
+typedef enum {
+    POWER_SECTION_TLS,   ///< TLS handshake in http_client
+    POWER_SECTION_JSON,  ///< cJSON parsing / printing
+    POWER_SECTION_I2C,   ///< Display transfers over I2C
+    POWER_SECTION_COUNT,
+} power_section_t;
+
+/**
+ * @brief Residency counters of one hot section.
+ */
+typedef struct {
+    uint32_t enter_count;  ///< Number of times the section was entered
+    uint64_t total_us;     ///< Total time spent inside the section
+    uint32_t max_us;       ///< Longest single stay in the section
+} power_section_stats_t;
+
+/**
+ * @brief Duty-cycle statistics, retained across deep sleep.
+ */
+typedef struct {
+    uint32_t cycle_count;              ///< Wake-ups from deep sleep since power-on
+    uint32_t last_wake_to_display_ms;  ///< esp_timer start → weather on screen (no ROM/bootloader)
+    uint32_t last_awake_ms;            ///< Time spent awake in the last completed cycle
+    uint64_t total_awake_ms;           ///< Sum of awake time over all completed cycles
+    uint64_t total_sleep_ms;           ///< Sum of requested sleep time
+} power_manager_stats_t;
+
+/**
+ * @brief Configure dynamic frequency scaling and automatic light sleep.
+ *
+ * Call once, early in app_main(). Returns ESP_ERR_NOT_SUPPORTED when the
+ * firmware is built without CONFIG_PM_ENABLE; hot sections then only count.
+ *
+ * @return ESP_OK on success, otherwise an error code.
+ */
+esp_err_t power_manager_init(void);
+
+/**
+ * @brief Enter a hot section: CPU at max frequency, light sleep blocked.
+ *
+ * Sections are reference counted and may be entered from several tasks.
+ *
+ * @param section Section being entered.
+ */
+void power_manager_section_begin(power_section_t section);
+
+/**
+ * @brief Leave a hot section entered with power_manager_section_begin().
+ *
+ * @param section Section being left.
+ */
+void power_manager_section_end(power_section_t section);
+
+/**
+ * @brief Copy the residency counters of all hot sections.
+ *
+ * @param[out] out Array of POWER_SECTION_COUNT entries.
+ */
+void power_manager_get_section_stats(power_section_stats_t out[POWER_SECTION_COUNT]);
+
+/**
+ * @brief Name of a hot section, for logs and reports.
+ */
+const char *power_manager_section_name(power_section_t section);
+
+/**
+ * @brief Log per-section residency and, with CONFIG_PM_PROFILING, the time
+ *        spent in each power mode (active / modem sleep / light sleep).
+ */
+void power_manager_dump_residency(void);
+
+/**
+ * @brief Check whether deep sleep duty cycling is compiled in.
+ *
+ * @return true if CONFIG_POWER_DEEP_SLEEP_MODE is enabled.
+ */
+bool power_manager_deep_sleep_enabled(void);
+
+/**
+ * @brief Check whether this boot is a timer wake-up from deep sleep.
+ *
+ * RTC-retained state is only meaningful when this returns true.
+ *
+ * @return true if woken by the deep sleep timer.
+ */
+bool power_manager_woke_from_sleep(void);
+
+/**
+ * @brief Record that fresh content is visible on the display.
+ *
+ * Only the first call after each wake-up is taken into account.
+ */
+void power_manager_mark_display_ready(void);
+
+/**
+ * @brief Enter deep sleep for the given duration. Does not return.
+ *
+ * The awake time of the current cycle is accounted before sleeping.
+ *
+ * @param sleep_ms Sleep duration in milliseconds.
+ */
+void power_manager_deep_sleep(uint32_t sleep_ms);
+
+/**
+ * @brief Copy the current duty-cycle statistics.
+ *
+ * @param[out] out Structure to fill.
+ */
+void power_manager_get_stats(power_manager_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // POWER_MANAGER_H
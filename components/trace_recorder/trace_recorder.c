@@ -0,0 +1,135 @@
+#include "trace_recorder.h"
+
+#if CONFIG_TRACE_RECORDER_ENABLE
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+/* Largest power of two not above the configured size, so the slot is a mask */
+#define TRACE_ENTRIES                                                                 \
+    (CONFIG_TRACE_RECORDER_ENTRIES >= 4096   ? 4096                                   \
+     : CONFIG_TRACE_RECORDER_ENTRIES >= 2048 ? 2048                                   \
+     : CONFIG_TRACE_RECORDER_ENTRIES >= 1024 ? 1024                                   \
+     : CONFIG_TRACE_RECORDER_ENTRIES >= 512  ? 512                                    \
+     : CONFIG_TRACE_RECORDER_ENTRIES >= 256  ? 256                                    \
+     : CONFIG_TRACE_RECORDER_ENTRIES >= 128  ? 128                                    \
+                                             : 64)
+
+#define TRACE_MAX_THREADS 32
+
+typedef struct {
+    uint64_t ts_us;    ///< esp_timer time
+    const char *name;  ///< String literal
+    atomic_uint seq;   ///< Event number + 1 once the fields are written, 0 while writing
+    uint16_t task;     ///< FreeRTOS task number (0 outside a task)
+    uint8_t core;
+    uint8_t phase;     ///< trace_phase_t
+} trace_entry_t;
+
+static trace_entry_t ring[TRACE_ENTRIES];
+static atomic_uint head;  ///< Total events recorded; slot is head % TRACE_ENTRIES
+static atomic_bool paused;
+
+void trace_record(const char *name, trace_phase_t phase)
+{
+    if (atomic_load_explicit(&paused, memory_order_relaxed))
+        return;
+
+    unsigned idx = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed);
+    trace_entry_t *e = &ring[idx & (TRACE_ENTRIES - 1)];
+
+    /* Readers skip the slot until seq names this event again */
+    atomic_store_explicit(&e->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    e->ts_us = (uint64_t)esp_timer_get_time();
+    e->name = name;
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    e->task = (uint16_t)uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle());
+#else
+    e->task = 0;
+#endif
+    e->core = (uint8_t)xPortGetCoreID();
+    e->phase = (uint8_t)phase;
+    atomic_store_explicit(&e->seq, idx + 1, memory_order_release);
+}
+
+/*
+ * Copy event i out of the ring. Fails if it is not written yet (a writer
+ * claimed the slot before the pause) or was overwritten while being copied.
+ */
+static bool read_entry(unsigned i, trace_entry_t *out)
+{
+    const trace_entry_t *e = &ring[i & (TRACE_ENTRIES - 1)];
+    unsigned seq = atomic_load_explicit(&e->seq, memory_order_acquire);
+    if (seq != i + 1)
+        return false;
+
+    out->ts_us = e->ts_us;
+    out->name = e->name;
+    out->task = e->task;
+    out->core = e->core;
+    out->phase = e->phase;
+
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&e->seq, memory_order_relaxed) == seq && out->name;
+}
+
+/* Name the Chrome "threads" after the tasks that are still alive */
+static void write_thread_names(json_writer_t *w)
+{
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    static TaskStatus_t tasks[TRACE_MAX_THREADS];  // Only used with recording paused
+    UBaseType_t n = uxTaskGetSystemState(tasks, TRACE_MAX_THREADS, NULL);
+    for (UBaseType_t i = 0; i < n; i++) {
+        json_writer_object_begin(w);
+        json_writer_kv_string(w, "name", "thread_name");
+        json_writer_kv_string(w, "ph", "M");
+        json_writer_kv_uint(w, "pid", 1);
+        json_writer_kv_uint(w, "tid", tasks[i].xTaskNumber);
+        json_writer_key(w, "args");
+        json_writer_object_begin(w);
+        json_writer_kv_string(w, "name", tasks[i].pcTaskName);
+        json_writer_object_end(w);
+        json_writer_object_end(w);
+    }
+#endif
+}
+
+esp_err_t trace_write_chrome_events(json_writer_t *w)
+{
+    char phase_str[2] = { 0 };
+
+    atomic_store(&paused, true);
+    write_thread_names(w);
+
+    unsigned end = atomic_load(&head);
+    unsigned start = (end > TRACE_ENTRIES) ? end - TRACE_ENTRIES : 0;
+    for (unsigned i = start; i < end; i++) {
+        trace_entry_t e;
+        if (!read_entry(i, &e))
+            continue;
+        phase_str[0] = (char)e.phase;
+
+        json_writer_object_begin(w);
+        json_writer_kv_string(w, "name", e.name);
+        json_writer_kv_string(w, "ph", phase_str);
+        json_writer_kv_uint(w, "ts", e.ts_us);
+        json_writer_kv_uint(w, "pid", 1);
+        json_writer_kv_uint(w, "tid", e.task);
+        if (e.phase == TRACE_PHASE_INSTANT)
+            json_writer_kv_string(w, "s", "t");  // Thread-scoped instant
+        json_writer_key(w, "args");
+        json_writer_object_begin(w);
+        json_writer_kv_uint(w, "core", e.core);
+        json_writer_object_end(w);
+        json_writer_object_end(w);
+    }
+
+    atomic_store(&paused, false);
+    return w->err;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file trace_recorder.h
+ * @brief Always-on span and instant event tracer with Chrome Trace export.
+ *
+ * Events go into a fixed ring buffer (CONFIG_TRACE_RECORDER_ENTRIES) with a
+ * 64-bit µs timestamp, the recording core and the FreeRTOS task number.
+ * Recording takes no lock; each entry is published by a sequence number
+ * written last, so readers never see a half-written event. Event names are
+ * stored by pointer and must be string literals. With
+ * CONFIG_TRACE_RECORDER_ENABLE off every call compiles to nothing.
+ */
+
+/** Chrome Trace Event phases used by the recorder. */
+typedef enum {
+    TRACE_PHASE_BEGIN = 'B',
+    TRACE_PHASE_END = 'E',
+    TRACE_PHASE_INSTANT = 'i',
+} trace_phase_t;
+
+#if CONFIG_TRACE_RECORDER_ENABLE
+
+/**
+ * @brief Record one event.
+ *
+ * @param name  Event name (string literal, kept by pointer).
+ * @param phase Begin, end or instant.
+ */
+void trace_record(const char *name, trace_phase_t phase);
+
+/**
+ * @brief Write the buffered events as the elements of a Chrome "traceEvents" array.
+ *
+ * Emits "thread_name" metadata for live tasks first, then the events from
+ * oldest to newest. Recording is paused while the buffer is walked; events
+ * a writer had claimed but not finished are left out.
+ *
+ * @param w Writer positioned inside an open JSON array.
+ *
+ * @return
+ *  - ESP_OK on success.
+ *  - The writer error if output failed.
+ */
+esp_err_t trace_write_chrome_events(json_writer_t *w);
+
+#else
+
+static inline void trace_record(const char *name, trace_phase_t phase)
+{
+    (void)name;
+    (void)phase;
+}
+
+static inline esp_err_t trace_write_chrome_events(json_writer_t *w)
+{
+    (void)w;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
+
+/** Open a span; close it with trace_end() on the same task. */
+static inline void trace_begin(const char *name)
+{
+    trace_record(name, TRACE_PHASE_BEGIN);
+}
+
+/** Close the span opened by trace_begin(). */
+static inline void trace_end(const char *name)
+{
+    trace_record(name, TRACE_PHASE_END);
+}
+
+/** Record a point event. */
+static inline void trace_instant(const char *name)
+{
+    trace_record(name, TRACE_PHASE_INSTANT);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TRACE_RECORDER_H
@@ -0,0 +1,12 @@
+#include "unity.h"
+#include "heap_monitor.h"
+#include "json_arena.h"
+
+void app_main(void)
+{
+    /* Same order as the firmware: accounting first, then the cJSON hooks */
+    heap_monitor_init();
+    json_arena_install_hooks();
+
+    unity_run_menu();
+}
@@ -0,0 +1,140 @@
+/*
+ * weather_data_fetch() against tools/mock_open_meteo.py, one case per fault.
+ * Each case checks the error code, that the fetch stayed within its time
+ * budget and that no tracked heap bytes were left behind.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "http_client.h"
+#include "weather_handler.h"
+#include "heap_monitor.h"
+
+#define MOCK_URL CONFIG_WEATHER_API_BASE_URL
+
+/* Every attempt is bounded by the HTTP deadline, every wait between them by the cap */
+#define FETCH_ATTEMPTS (CONFIG_WEATHER_FETCH_RETRIES + 1)
+#define FETCH_BUDGET_MS                               \
+    (HTTP_CLIENT_DEADLINE_MS * FETCH_ATTEMPTS +       \
+     CONFIG_WEATHER_RETRY_MAX_WAIT_MS * CONFIG_WEATHER_FETCH_RETRIES)
+
+/* Marks fields the fetch must not touch on failure */
+#define SENTINEL_TEMPERATURE (-999.0f)
+
+static void set_fault(const char *mode, int count)
+{
+    char url[128];
+    char reply[64];
+    snprintf(url, sizeof(url), MOCK_URL "/_fault?mode=%s&count=%d", mode, count);
+    TEST_ASSERT_EQUAL_MESSAGE(ESP_OK, http_get(url, reply, sizeof(reply), NULL),
+                              "mock server not reachable, see pytest_weather_fetch.py");
+}
+
+static uint32_t tracked_live_bytes(void)
+{
+    uint32_t live = 0;
+    for (int m = 0; m < HEAP_MODULE_COUNT; m++) {
+        heap_module_stats_t st;
+        heap_monitor_get_module(m, &st);
+        live += st.live_bytes;
+    }
+    return live;
+}
+
+/* Fetch once with the given fault active for @p count requests (0 = all) */
+static uint32_t fetch_with_fault(const char *mode, int count, esp_err_t expected,
+                                 weather_data_t *out)
+{
+    *out = (weather_data_t) { .temperature = SENTINEL_TEMPERATURE };
+    set_fault(mode, count);
+
+    uint32_t live_before = tracked_live_bytes();
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = weather_data_fetch(-30.0f, -51.125f, out);
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    uint32_t live_after = tracked_live_bytes();
+    set_fault("ok", 0);
+
+    TEST_ASSERT_EQUAL_HEX32_MESSAGE(expected, err, mode);
+    TEST_ASSERT_LESS_THAN_UINT32_MESSAGE(FETCH_BUDGET_MS, elapsed_ms, mode);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(live_before, live_after, mode);
+    return elapsed_ms;
+}
+
+TEST_CASE("recorded reply is parsed", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("ok", 0, ESP_OK, &w);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 21.4f, w.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 63.0f, w.humidity);
+    TEST_ASSERT_EQUAL_INT(2, w.weather_code);
+    TEST_ASSERT_TRUE(w.is_day);
+    TEST_ASSERT_NOT_EQUAL(0, w.timestamp);
+}
+
+TEST_CASE("slow reply within the I/O timeout succeeds", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("latency", 0, ESP_OK, &w);
+}
+
+TEST_CASE("body in small pieces is reassembled", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("partial", 0, ESP_OK, &w);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 21.4f, w.temperature);
+}
+
+TEST_CASE("trickling body is cut by the deadline", "[weather_fetch][slow]")
+{
+    weather_data_t w;
+    uint32_t elapsed_ms = fetch_with_fault("trickle", 0, ESP_ERR_TIMEOUT, &w);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(HTTP_CLIENT_DEADLINE_MS, elapsed_ms);
+    TEST_ASSERT_EQUAL_FLOAT(SENTINEL_TEMPERATURE, w.temperature);
+}
+
+TEST_CASE("truncated body is rejected", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("truncated", 0, ESP_ERR_INVALID_RESPONSE, &w);
+    TEST_ASSERT_EQUAL_FLOAT(SENTINEL_TEMPERATURE, w.temperature);
+}
+
+TEST_CASE("oversized body is rejected", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("oversized", 0, ESP_ERR_INVALID_SIZE, &w);
+    fetch_with_fault("oversized_raw", 0, ESP_ERR_INVALID_SIZE, &w);
+    TEST_ASSERT_EQUAL_FLOAT(SENTINEL_TEMPERATURE, w.temperature);
+}
+
+TEST_CASE("invalid JSON fails the parse", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("invalid_json", 0, ESP_FAIL, &w);
+    TEST_ASSERT_EQUAL_FLOAT(SENTINEL_TEMPERATURE, w.temperature);
+}
+
+TEST_CASE("missing field fails the parse", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("missing_field", 0, ESP_FAIL, &w);
+    TEST_ASSERT_EQUAL_FLOAT(SENTINEL_TEMPERATURE, w.temperature);
+}
+
+TEST_CASE("persistent 429 and 5xx exhaust the retries", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("429", 0, ESP_ERR_INVALID_RESPONSE, &w);
+    fetch_with_fault("500", 0, ESP_ERR_INVALID_RESPONSE, &w);
+    fetch_with_fault("503", 0, ESP_ERR_INVALID_RESPONSE, &w);
+}
+
+TEST_CASE("transient 503 recovers on retry", "[weather_fetch]")
+{
+    weather_data_t w;
+    fetch_with_fault("503", CONFIG_WEATHER_FETCH_RETRIES, ESP_OK, &w);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 21.4f, w.temperature);
+}
@@ -0,0 +1,38 @@
+# Runs the Unity cases of this app (linux target) against tools/mock_open_meteo.py
+import os
+import socket
+import subprocess
+import sys
+import time
+
+import pytest
+from pytest_embedded import Dut
+
+MOCK = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', '..', 'tools',
+                    'mock_open_meteo.py')
+MOCK_PORT = 8080  # CONFIG_WEATHER_API_BASE_URL in sdkconfig.defaults
+
+
+@pytest.fixture
+def mock_server():
+    proc = subprocess.Popen([sys.executable, MOCK, '--port', str(MOCK_PORT)])
+    deadline = time.monotonic() + 10
+    while True:
+        try:
+            socket.create_connection(('127.0.0.1', MOCK_PORT), timeout=1).close()
+            break
+        except OSError:
+            if time.monotonic() > deadline:
+                proc.kill()
+                raise
+            time.sleep(0.1)
+    yield
+    proc.terminate()
+    proc.wait()
+
+
+@pytest.mark.linux
+@pytest.mark.host_test
+def test_weather_fetch(mock_server, dut: Dut) -> None:
+    # The trickle case alone takes (retries + 1) HTTP deadlines
+    dut.run_all_single_board_cases(timeout=120)
@@ -1,9 +1,17 @@
 #include <stdio.h>
 #include <string.h>
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "cJSON.h"
 #include "http_client.h"
 #include "weather_handler.h"
+#include "power_manager.h"
+#include "metrics.h"
+#include "esp_timer.h"
+#include "trace_recorder.h"
+#include "json_arena.h"
+#include "sdkconfig.h"
 
 static const char *TAG = "WEATHER_DATA";
 
@@ -11,22 +19,27 @@ static const char *TAG = "WEATHER_DATA";
 #define WEATHER_HTTP_BUFFER_SIZE 4096
 static char http_response[WEATHER_HTTP_BUFFER_SIZE];
 
+// cJSON tree of one response (~1.5 KB for the current-weather reply), reset after each parse
+#define WEATHER_JSON_ARENA_SIZE 4096
+static uint64_t json_arena_buf[WEATHER_JSON_ARENA_SIZE / sizeof(uint64_t)];
+static json_arena_t json_arena = JSON_ARENA_STATIC_INIT(json_arena_buf);
+
 /**
  * @brief Construct an URL to API Open-Meteo.
  */
-static void build_weather_url(char *url_out, size_t max_len, float lat, float lon)
+void weather_data_build_url(char *url_out, size_t max_len, float lat, float lon)
 {
     snprintf(url_out, max_len,
-             "https://api.open-meteo.com/v1/forecast?"
+             CONFIG_WEATHER_API_BASE_URL "/v1/forecast?"
              "latitude=%.6f&longitude=%.6f&current=temperature_2m,relative_humidity_2m,"
-             "is_day,precipitation,weather_code&forecast_days=1",
+             "is_day,precipitation,weather_code&forecast_days=1&timeformat=unixtime",
              lat, lon);
 }
 
 /**
  * @brief JSON Parsing from Open-Meteo API
  */
-static esp_err_t parse_weather_json(const char *json, weather_data_t *out)
+esp_err_t weather_data_parse(const char *json, weather_data_t *out)
 {
     cJSON *root = cJSON_Parse(json);
     if (!root) {
@@ -41,16 +54,76 @@ static esp_err_t parse_weather_json(const char *json, weather_data_t *out)
         return ESP_FAIL;
     }
 
-    out->temperature = cJSON_GetObjectItem(current, "temperature_2m")->valuedouble;
-    out->humidity = cJSON_GetObjectItem(current, "relative_humidity_2m")->valuedouble;
-    out->precipitation = cJSON_GetObjectItem(current, "precipitation")->valuedouble;
-    out->weather_code = cJSON_GetObjectItem(current, "weather_code")->valueint;
-    out->is_day = cJSON_GetObjectItem(current, "is_day")->valueint;
+    /* Every field must be present and numeric: a partial reply is an error, not zeros */
+    cJSON *temperature = cJSON_GetObjectItem(current, "temperature_2m");
+    cJSON *humidity = cJSON_GetObjectItem(current, "relative_humidity_2m");
+    cJSON *precipitation = cJSON_GetObjectItem(current, "precipitation");
+    cJSON *weather_code = cJSON_GetObjectItem(current, "weather_code");
+    cJSON *is_day = cJSON_GetObjectItem(current, "is_day");
+    if (!cJSON_IsNumber(temperature) || !cJSON_IsNumber(humidity) ||
+        !cJSON_IsNumber(precipitation) || !cJSON_IsNumber(weather_code) ||
+        !cJSON_IsNumber(is_day)) {
+        ESP_LOGE(TAG, "Missing or non-numeric field in 'current'");
+        cJSON_Delete(root);
+        return ESP_FAIL;
+    }
+
+    out->temperature = temperature->valuedouble;
+    out->humidity = humidity->valuedouble;
+    out->precipitation = precipitation->valuedouble;
+    out->weather_code = weather_code->valueint;
+    out->is_day = is_day->valueint;
+
+    // Observation time, requested as Unix time (timeformat=unixtime)
+    cJSON *time = cJSON_GetObjectItem(current, "time");
+    out->timestamp = cJSON_IsNumber(time) ? (uint32_t)time->valuedouble : 0;
 
     cJSON_Delete(root);
     return ESP_OK;
 }
 
+/**
+ * @brief Whether a failed GET may succeed if repeated
+ */
+static bool is_retryable(esp_err_t err, const http_response_info_t *info)
+{
+    if (info->status == 429 || info->status >= 500)
+        return true;
+    if (info->status >= 300)
+        return false;  // Other statuses will not change on their own
+    return err == ESP_FAIL || err == ESP_ERR_TIMEOUT || err == ESP_ERR_INVALID_RESPONSE;
+}
+
+/**
+ * @brief GET the reply, retrying transient failures with a bounded backoff
+ */
+static esp_err_t get_with_retries(const char *url)
+{
+    uint32_t backoff_ms = CONFIG_WEATHER_RETRY_BACKOFF_MS;
+    for (int attempt = 0;; attempt++) {
+        http_response_info_t info;
+        esp_err_t err = http_get(url, http_response, sizeof(http_response), &info);
+        if (err == ESP_OK || attempt >= CONFIG_WEATHER_FETCH_RETRIES ||
+            !is_retryable(err, &info))
+            return err;
+
+        /* Clamp before scaling: a huge Retry-After would wrap around in ms */
+        uint32_t wait_ms = backoff_ms;
+        if (info.retry_after_s > CONFIG_WEATHER_RETRY_MAX_WAIT_MS / 1000)
+            wait_ms = CONFIG_WEATHER_RETRY_MAX_WAIT_MS;
+        else if (info.retry_after_s)
+            wait_ms = info.retry_after_s * 1000;
+        if (wait_ms > CONFIG_WEATHER_RETRY_MAX_WAIT_MS)
+            wait_ms = CONFIG_WEATHER_RETRY_MAX_WAIT_MS;
+        ESP_LOGW(TAG, "Fetch attempt %d failed (%s, status %d), retrying in %u ms", attempt + 1,
+                 esp_err_to_name(err), info.status, (unsigned)wait_ms);
+        metrics_inc(METRIC_WEATHER_FETCH_RETRIES);
+        trace_instant("weather_retry");
+        vTaskDelay(pdMS_TO_TICKS(wait_ms));
+        backoff_ms *= 2;
+    }
+}
+
 /**
  * @brief Execute a HTTP requests and parsing
  */
@@ -61,17 +134,29 @@ esp_err_t weather_data_fetch(float latitude, float longitude, weather_data_t *ou
     }
 
     char url[256];
-    build_weather_url(url, sizeof(url), latitude, longitude);
+    weather_data_build_url(url, sizeof(url), latitude, longitude);
 
     ESP_LOGI(TAG, "Fetching weather data from: %s", url);
 
-    esp_err_t err = http_get(url, http_response, sizeof(http_response));
+    trace_begin("weather_fetch");
+    esp_err_t err = get_with_retries(url);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "HTTP GET failed: %s", esp_err_to_name(err));
+        trace_end("weather_fetch");
         return err;
     }
 
-    err = parse_weather_json(http_response, out_data);
+    power_manager_section_begin(POWER_SECTION_JSON);
+    trace_begin("weather_parse");
+    int64_t parse_start = esp_timer_get_time();
+    json_arena_bind(&json_arena);
+    err = weather_data_parse(http_response, out_data);
+    json_arena_bind(NULL);
+    json_arena_reset(&json_arena);
+    metrics_observe_us(METRIC_WEATHER_PARSE_TIME, (uint32_t)(esp_timer_get_time() - parse_start));
+    trace_end("weather_parse");
+    power_manager_section_end(POWER_SECTION_JSON);
+    trace_end("weather_fetch");
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to parse weather data");
         return err;
@@ -2,6 +2,9 @@
 #define WEATHER_HANDLER_H
 
 #include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +27,7 @@ typedef struct {
     float precipitation;  ///< Precipitation rate in mm/h
     int weather_code;     ///< WMO numeric weather condition code
     bool is_day;          ///< True if daytime, false if nighttime
+    uint32_t timestamp;   ///< Observation time, Unix seconds (UTC), 0 if unknown
 } weather_data_t;
 
 /**
@@ -39,10 +43,38 @@ typedef struct {
  * @return
  *  - ESP_OK                       Success
  *  - ESP_ERR_INVALID_ARG          Invalid parameters
- *  - ESP_FAIL                     Request or parsing failure
+ *  - ESP_ERR_INVALID_RESPONSE     Error status or body cut short (after the retries)
+ *  - ESP_ERR_INVALID_SIZE         Reply larger than the response buffer
+ *  - ESP_ERR_TIMEOUT              Deadline expired (after the retries)
+ *  - ESP_FAIL                     Connection or parsing failure
  */
 esp_err_t weather_data_fetch(float latitude, float longitude, weather_data_t *out_data);
 
+/**
+ * @brief Build the Open-Meteo request URL for a location.
+ *
+ * @param url_out   Destination buffer (256 bytes fit any location).
+ * @param max_len   Size of @p url_out.
+ * @param latitude  Geographic latitude in decimal degrees.
+ * @param longitude Geographic longitude in decimal degrees.
+ */
+void weather_data_build_url(char *url_out, size_t max_len, float latitude, float longitude);
+
+/**
+ * @brief Parse an Open-Meteo current-weather JSON reply.
+ *
+ * cJSON nodes come from the arena bound to the calling task, if any (see
+ * json_arena_bind()), otherwise from the heap.
+ *
+ * @param json Null-terminated response body.
+ * @param out  Pointer to a structure where parsed weather data is stored.
+ *
+ * @return
+ *  - ESP_OK    Success
+ *  - ESP_FAIL  Invalid JSON or missing 'current' object
+ */
+esp_err_t weather_data_parse(const char *json, weather_data_t *out);
+
 /**
  * @brief Convert a WMO weather code into a short textual description.
  *
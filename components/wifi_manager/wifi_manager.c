@@ -4,20 +4,66 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
-#include "nvs_manager.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_attr.h"
+#include "config_manager.h"
+#include "metrics.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include <stdatomic.h>
 #include <string.h>
 
 static const char *TAG = "WIFI_MANAGER";
 static bool wifi_initialized = false;
 
+/* Reconnect backoff: base delay doubled per failed attempt, capped */
+#define WIFI_RECONNECT_BASE_MS 1000
+#define WIFI_RECONNECT_MAX_MS 300000
+
+/* Time the portal stays up after new credentials got an IP, so the page can show the result */
+#define PORTAL_EXIT_DELAY_MS 5000
+
+/* --- Link quality telemetry (guarded by stats_lock) --- */
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_manager_stats_t stats;
+static size_t history_head = 0;
+static int64_t disconnected_at_us = 0;
+static esp_timer_handle_t reconnect_timer = NULL;
+static esp_timer_handle_t portal_exit_timer = NULL;
+
+static bool sta_ready = false;          // STA netif and event handlers created
+static bool connect_on_start = false;   // STA_START issues the first connect
+static bool config_mode = false;        // SoftAP + portal running
+static atomic_bool reconfiguring;       // Disconnect requested to apply new credentials
+static bool exit_portal_on_ip = false;  // Leave config mode once new credentials connect
+
+/* Set while the station holds an IP */
+#define LINK_CONNECTED_BIT (1 << 0)
+static EventGroupHandle_t link_events = NULL;
+
+/* --- Fast-connect info, retained in RTC memory across deep sleep --- */
+#define FAST_CONNECT_MAGIC 0x46434E31  // "FCN1"
+
+typedef struct {
+    uint32_t magic;
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+} fast_connect_t;
+
+static RTC_DATA_ATTR fast_connect_t fast_connect;
+static bool fast_connect_used = false;
+
 /* --- Forward declarations --- */
 static void base_init_once(void);
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id,
                                void *event_data);
+static esp_err_t sta_setup_once(void);
+static esp_err_t wifi_set_sta_config(const char *ssid, const char *pass);
 static void wifi_init_sta(const char *ssid, const char *pass);
-static void wifi_init_softap(void);
+static void wifi_init_softap(const char *ssid, const char *pass);
 
 /* --- base init (run once) --- */
 static void base_init_once(void)
@@ -31,52 +77,271 @@ static void base_init_once(void)
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
+    link_events = xEventGroupCreate();
+
     wifi_initialized = true;
     ESP_LOGI(TAG, "Base Wi-Fi subsystem initialized");
 }
 
+/* --- Telemetry helpers --- */
+
+/* Append one entry to the link history ring. Caller must hold stats_lock. */
+static void history_push_locked(wifi_manager_link_event_type_t type, uint16_t reason, int8_t rssi,
+                                uint32_t reconnect_ms)
+{
+    wifi_manager_link_event_t *e = &stats.history[history_head];
+    e->timestamp_us = esp_timer_get_time();
+    e->type = type;
+    e->reason = reason;
+    e->rssi = rssi;
+    e->reconnect_ms = reconnect_ms;
+
+    history_head = (history_head + 1) % WIFI_MANAGER_HISTORY_LEN;
+    if (stats.history_len < WIFI_MANAGER_HISTORY_LEN)
+        stats.history_len++;
+}
+
+/* Exponential backoff with up to 25% random jitter so several devices
+ * behind the same AP do not retry in lockstep. */
+static uint32_t backoff_delay_ms(uint32_t attempt)
+{
+    uint32_t delay = WIFI_RECONNECT_MAX_MS;
+    if (attempt < 16) {
+        delay = WIFI_RECONNECT_BASE_MS << attempt;
+        if (delay > WIFI_RECONNECT_MAX_MS)
+            delay = WIFI_RECONNECT_MAX_MS;
+    }
+    return delay + (esp_random() % (delay / 4 + 1));
+}
+
+static void reconnect_timer_cb(void *arg)
+{
+    portENTER_CRITICAL(&stats_lock);
+    uint32_t attempt = stats.reconnect_attempts;
+    portEXIT_CRITICAL(&stats_lock);
+
+    ESP_LOGI(TAG, "Reconnect attempt %u", (unsigned)attempt);
+    esp_wifi_connect();
+}
+
+/* New credentials work: drop the AP and the portal, back to plain station mode */
+static void portal_exit_timer_cb(void *arg)
+{
+    if (!config_mode)
+        return;
+
+    esp_err_t err = esp_wifi_set_mode(WIFI_MODE_STA);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Leaving config mode failed: %s", esp_err_to_name(err));
+        return;
+    }
+    http_server_set_portal(false);
+    config_mode = false;
+    ESP_LOGI(TAG, "Config mode finished, SoftAP stopped");
+}
+
+/* --- Link state push to /api/events subscribers (no-op without subscribers) --- */
+static void push_link_state(bool connected, int8_t rssi, uint8_t reason, uint32_t reconnects)
+{
+    char json[96];
+    snprintf(json, sizeof(json),
+             "{\"connected\":%s,\"rssi\":%d,\"reason\":%u,\"reconnects\":%u}",
+             connected ? "true" : "false", rssi, reason, (unsigned)reconnects);
+    http_server_push_event(HTTP_SERVER_EVENT_WIFI, json);
+}
+
 /* --- Wi-Fi event handler --- */
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id,
                                void *event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        if (connect_on_start)
+            esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        ESP_LOGW(TAG, "STA disconnected, attempting reconnection...");
-        esp_wifi_connect();
+        const wifi_event_sta_disconnected_t *ev = (const wifi_event_sta_disconnected_t *)event_data;
+        xEventGroupClearBits(link_events, LINK_CONNECTED_BIT);
+
+        if (atomic_exchange(&reconfiguring, false)) {
+            /* Our own disconnect to switch networks: not a link drop, and the new connect is
+             * already issued with a fresh backoff */
+            portENTER_CRITICAL(&stats_lock);
+            stats.connected = false;
+            portEXIT_CRITICAL(&stats_lock);
+            ESP_LOGI(TAG, "STA disconnected for reconfiguration");
+            return;
+        }
+
+        /* Stale BSSID/channel hint: fall back to a full scan for the next attempts */
+        if (fast_connect_used) {
+            ESP_LOGW(TAG, "Fast connect failed, dropping cached BSSID/channel");
+            fast_connect_used = false;
+            fast_connect.magic = 0;
+
+            wifi_config_t cfg;
+            if (esp_wifi_get_config(WIFI_IF_STA, &cfg) == ESP_OK) {
+                cfg.sta.bssid_set = false;
+                cfg.sta.channel = 0;
+                esp_wifi_set_config(WIFI_IF_STA, &cfg);
+            }
+        }
+
+        portENTER_CRITICAL(&stats_lock);
+        if (stats.connected || disconnected_at_us == 0) {
+            disconnected_at_us = esp_timer_get_time();
+            stats.disconnect_count++;
+        }
+        stats.connected = false;
+        stats.last_reason = ev->reason;
+        stats.last_rssi = ev->rssi;
+        uint32_t delay_ms = backoff_delay_ms(stats.reconnect_attempts);
+        stats.reconnect_attempts++;
+        stats.next_retry_at_us = esp_timer_get_time() + (int64_t)delay_ms * 1000;
+        history_push_locked(WIFI_MANAGER_LINK_DISCONNECTED, ev->reason, ev->rssi, 0);
+        uint32_t reconnects = stats.reconnect_count;
+        portEXIT_CRITICAL(&stats_lock);
+
+        push_link_state(false, ev->rssi, ev->reason, reconnects);
+
+        esp_timer_stop(reconnect_timer);
+        ESP_LOGW(TAG, "STA disconnected (reason=%u, rssi=%d), retry in %u ms", ev->reason, ev->rssi,
+                 (unsigned)delay_ms);
+        esp_timer_start_once(reconnect_timer, (uint64_t)delay_ms * 1000);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ESP_LOGI(TAG, "STA got IP");
+        wifi_ap_record_t ap;
+        int8_t rssi = 0;
+        if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+            rssi = ap.rssi;
+
+            /* Remember where the AP lives so the next wake-up can skip the scan */
+            strlcpy(fast_connect.ssid, (const char *)ap.ssid, sizeof(fast_connect.ssid));
+            memcpy(fast_connect.bssid, ap.bssid, sizeof(fast_connect.bssid));
+            fast_connect.channel = ap.primary;
+            fast_connect.magic = FAST_CONNECT_MAGIC;
+        }
+        fast_connect_used = false;
+
+        portENTER_CRITICAL(&stats_lock);
+        uint32_t reconnect_ms = 0;
+        if (disconnected_at_us != 0) {
+            reconnect_ms = (uint32_t)((esp_timer_get_time() - disconnected_at_us) / 1000);
+            stats.last_reconnect_ms = reconnect_ms;
+            if (reconnect_ms > stats.max_reconnect_ms)
+                stats.max_reconnect_ms = reconnect_ms;
+            stats.total_reconnect_ms += reconnect_ms;
+            stats.reconnect_count++;
+        }
+        disconnected_at_us = 0;
+        stats.connected = true;
+        stats.reconnect_attempts = 0;
+        stats.next_retry_at_us = 0;
+        stats.last_rssi = rssi;
+        history_push_locked(WIFI_MANAGER_LINK_CONNECTED, 0, rssi, reconnect_ms);
+        uint32_t reconnects = stats.reconnect_count;
+        portEXIT_CRITICAL(&stats_lock);
+
+        xEventGroupSetBits(link_events, LINK_CONNECTED_BIT);
+        push_link_state(true, rssi, 0, reconnects);
+        metrics_gauge_set(METRIC_WIFI_RSSI, rssi);
+        if (reconnect_ms > 0)
+            metrics_inc(METRIC_WIFI_RECONNECTS);
+        ESP_LOGI(TAG, "STA got IP (rssi=%d, reconnect took %u ms)", rssi, (unsigned)reconnect_ms);
+
+        if (exit_portal_on_ip) {
+            exit_portal_on_ip = false;
+            esp_timer_stop(portal_exit_timer);
+            esp_timer_start_once(portal_exit_timer, (uint64_t)PORTAL_EXIT_DELAY_MS * 1000);
+        }
     }
 }
 
-/* --- Wi-Fi STA init (assume base_init_once already called) --- */
-static void wifi_init_sta(const char *ssid, const char *pass)
+/* --- STA netif, timers and event handlers (run once) --- */
+static esp_err_t sta_setup_once(void)
 {
-    ESP_LOGI(TAG, "Starting STA mode to connect to SSID: %s", ssid);
+    if (sta_ready)
+        return ESP_OK;
+
+    esp_err_t err;
+    if (!reconnect_timer) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = reconnect_timer_cb,
+            .name = "wifi_reconnect",
+        };
+        err = esp_timer_create(&timer_args, &reconnect_timer);
+        if (err != ESP_OK)
+            return err;
+    }
+    if (!portal_exit_timer) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = portal_exit_timer_cb,
+            .name = "portal_exit",
+        };
+        err = esp_timer_create(&timer_args, &portal_exit_timer);
+        if (err != ESP_OK)
+            return err;
+    }
 
     /* create default netif for STA */
-    esp_netif_create_default_wifi_sta();
+    if (!esp_netif_create_default_wifi_sta())
+        return ESP_FAIL;
 
     esp_event_handler_instance_t instance_any_id;
     esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(
-        WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(
-        IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL, &instance_got_ip));
+    err = esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler,
+                                              NULL, &instance_any_id);
+    if (err != ESP_OK)
+        return err;
+    err = esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler,
+                                              NULL, &instance_got_ip);
+    if (err != ESP_OK)
+        return err;
+
+    sta_ready = true;
+    return ESP_OK;
+}
 
+/* --- Load STA credentials into the driver (assume sta_setup_once already called) --- */
+static esp_err_t wifi_set_sta_config(const char *ssid, const char *pass)
+{
     wifi_config_t wifi_config = { 0 };
     strncpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
     strncpy((char *)wifi_config.sta.password, pass, sizeof(wifi_config.sta.password) - 1);
 
+    /* Valid fast-connect info for this SSID → connect directly, no channel scan */
+    fast_connect_used = false;
+    if (fast_connect.magic == FAST_CONNECT_MAGIC && strcmp(fast_connect.ssid, ssid) == 0) {
+        ESP_LOGI(TAG, "Fast connect: channel %u", fast_connect.channel);
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, fast_connect.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = fast_connect.channel;
+        fast_connect_used = true;
+    }
+
+    return esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+}
+
+/* --- Wi-Fi STA init (assume base_init_once already called) --- */
+static void wifi_init_sta(const char *ssid, const char *pass)
+{
+    ESP_LOGI(TAG, "Starting STA mode to connect to SSID: %s", ssid);
+
+    ESP_ERROR_CHECK(sta_setup_once());
+
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(wifi_set_sta_config(ssid, pass));
+    connect_on_start = true;
     ESP_ERROR_CHECK(esp_wifi_start());
+
+    /* Modem sleep: radio wakes up for each DTIM beacon only, which also
+       lets the chip enter automatic light sleep between beacons */
+    esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
 }
 
-/* --- Wi-Fi SoftAP init (assume base_init_once already called) --- */
-static void wifi_init_softap(void)
+/* --- Wi-Fi SoftAP init (assume base_init_once already called) ---
+ * With credentials the station keeps running next to the AP (AP+STA), so
+ * weather updates continue while the portal is open. Returns immediately. */
+static void wifi_init_softap(const char *ssid, const char *pass)
 {
-    ESP_LOGW(TAG, "Starting SoftAP for config mode...");
+    ESP_LOGW(TAG, "Starting SoftAP for config mode (%s)...", ssid ? "AP+STA" : "AP only");
 
     /* create default netif for AP after esp_wifi_init (base_init_once does that) */
     esp_netif_create_default_wifi_ap();
@@ -97,45 +362,169 @@ static void wifi_init_softap(void)
         ap_config.ap.authmode = WIFI_AUTH_OPEN;
     }
 
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
+    if (ssid) {
+        ESP_ERROR_CHECK(sta_setup_once());
+        ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
+        ESP_ERROR_CHECK(wifi_set_sta_config(ssid, pass));
+        connect_on_start = true;
+    } else {
+        ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
+    }
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &ap_config));
     ESP_ERROR_CHECK(esp_wifi_start());
 
-    /* start HTTP server so user can POST credentials */
-    http_server_start();
+    config_mode = true;
 
-    while (true) {
-        ESP_LOGI(TAG, "Waiting new configuration!");
-        vTaskDelay(pdMS_TO_TICKS(2500));
-    }
+    /* expose the portal pages so the user can POST credentials */
+    http_server_set_portal(true);
+}
+
+/* --- Config change subscriber --- */
+static void on_config_changed(const app_config_t *cfg, uint32_t changed, void *ctx)
+{
+    if (!(changed & APP_CONFIG_CHANGED_WIFI))
+        return;
+
+    esp_err_t err = wifi_manager_apply_credentials(cfg->wifi_ssid, cfg->wifi_pass);
+    if (err != ESP_OK)
+        ESP_LOGE(TAG, "Applying new credentials failed: %s", esp_err_to_name(err));
 }
 
 /* --- Public init --- */
 void wifi_manager_init(bool force_config)
 {
-    /* ensure NVS is initialized (nvs_manager_init internally call nvs_flash_init) */
-    nvs_manager_init();
+    /* ensure the config is loaded (config_manager_init internally call nvs_flash_init) */
+    config_manager_init();
 
     /* initialize base Wi-Fi internals ONCE and in the correct order */
     base_init_once();
 
-    /* cfg button pressed → ignorate NVS and start AP */
-    if (force_config) {
-        ESP_LOGW(TAG, "Force config mode requested → Starting SoftAP");
-        wifi_init_softap();
-        return;
-    }
+    /* Credentials saved later in the portal are applied live */
+    config_manager_subscribe(on_config_changed, NULL);
 
-    /* Normal case – attempt to read credentials */
-    char ssid[64] = { 0 }, pass[64] = { 0 };
-    esp_err_t r1 = nvs_manager_read_str("wifi_ssid", ssid, sizeof(ssid));
-    esp_err_t r2 = nvs_manager_read_str("wifi_pass", pass, sizeof(pass));
+    /* Attempt to read credentials */
+    app_config_t cfg;
+    config_manager_get(&cfg);
+    const char *ssid = cfg.wifi_ssid;
+    const char *pass = cfg.wifi_pass;
+    bool has_credentials = strlen(ssid) > 0;
 
-    if (r1 == ESP_OK && r2 == ESP_OK && strlen(ssid) > 0) {
+    if (force_config) {
+        /* cfg button pressed → start AP, keep the station up next to it */
+        ESP_LOGW(TAG, "Force config mode requested → Starting SoftAP");
+        wifi_init_softap(has_credentials ? ssid : NULL, pass);
+    } else if (has_credentials) {
         ESP_LOGI(TAG, "Stored credentials found, attempting STA connect");
         wifi_init_sta(ssid, pass);
     } else {
         ESP_LOGW(TAG, "No stored credentials → Starting SoftAP");
-        wifi_init_softap();
+        wifi_init_softap(NULL, NULL);
+    }
+}
+
+esp_err_t wifi_manager_apply_credentials(const char *ssid, const char *pass)
+{
+    if (!ssid || !pass || strlen(ssid) == 0)
+        return ESP_ERR_INVALID_ARG;
+    if (!wifi_initialized)
+        return ESP_ERR_INVALID_STATE;
+
+    ESP_LOGI(TAG, "Applying new credentials for SSID: %s", ssid);
+    esp_err_t err = sta_setup_once();
+    if (err != ESP_OK)
+        return err;
+
+    /* Start over with a fresh backoff for the new network */
+    esp_timer_stop(reconnect_timer);
+    esp_timer_stop(portal_exit_timer);
+    exit_portal_on_ip = config_mode;
+    portENTER_CRITICAL(&stats_lock);
+    stats.reconnect_attempts = 0;
+    stats.next_retry_at_us = 0;
+    bool was_connected = stats.connected;
+    portEXIT_CRITICAL(&stats_lock);
+
+    wifi_mode_t mode = WIFI_MODE_NULL;
+    esp_wifi_get_mode(&mode);
+    if (mode == WIFI_MODE_AP) {
+        /* Portal was AP only: add the station first, STA config needs STA mode.
+         * The connect below is the only one, STA_START must not issue another. */
+        connect_on_start = false;
+        err = esp_wifi_set_mode(WIFI_MODE_APSTA);
+        if (err != ESP_OK)
+            return err;
+    } else {
+        /* The disconnect event of the old link must not schedule a backoff retry */
+        atomic_store(&reconfiguring, was_connected);
+        esp_wifi_disconnect();
+    }
+
+    err = wifi_set_sta_config(ssid, pass);
+    if (err != ESP_OK) {
+        atomic_store(&reconfiguring, false);
+        return err;
+    }
+    return esp_wifi_connect();
+}
+
+bool wifi_manager_is_config_mode(void)
+{
+    return config_mode;
+}
+
+bool wifi_manager_wait_connected(uint32_t timeout_ms)
+{
+    if (!link_events)
+        return false;
+
+    EventBits_t bits = xEventGroupWaitBits(link_events, LINK_CONNECTED_BIT, pdFALSE, pdTRUE,
+                                           pdMS_TO_TICKS(timeout_ms));
+    return (bits & LINK_CONNECTED_BIT) != 0;
+}
+
+/* --- Telemetry API --- */
+bool wifi_manager_is_connected(void)
+{
+    portENTER_CRITICAL(&stats_lock);
+    bool connected = stats.connected;
+    portEXIT_CRITICAL(&stats_lock);
+    return connected;
+}
+
+uint32_t wifi_manager_next_retry_ms(void)
+{
+    portENTER_CRITICAL(&stats_lock);
+    int64_t at = stats.next_retry_at_us;
+    portEXIT_CRITICAL(&stats_lock);
+
+    int64_t now = esp_timer_get_time();
+    return (at > now) ? (uint32_t)((at - now) / 1000) : 0;
+}
+
+void wifi_manager_sample_rssi(void)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK)
+        return;
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.last_rssi = ap.rssi;
+    history_push_locked(WIFI_MANAGER_LINK_RSSI_SAMPLE, 0, ap.rssi, 0);
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void wifi_manager_get_stats(wifi_manager_stats_t *out)
+{
+    if (!out)
+        return;
+
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    /* Hand out the history oldest-first instead of in ring order */
+    size_t start = (history_head + WIFI_MANAGER_HISTORY_LEN - stats.history_len) %
+                   WIFI_MANAGER_HISTORY_LEN;
+    for (size_t i = 0; i < stats.history_len; i++) {
+        out->history[i] = stats.history[(start + i) % WIFI_MANAGER_HISTORY_LEN];
     }
+    portEXIT_CRITICAL(&stats_lock);
 }
@@ -1,7 +1,10 @@
 #ifndef WIFI_MANAGER_H
 #define WIFI_MANAGER_H
 
+#include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,17 +20,129 @@ extern "C" {
  *  - Configuration mode: start a local access point for configuration.
  */
 
+/** Number of link events kept in the telemetry ring buffer. */
+#define WIFI_MANAGER_HISTORY_LEN 16
+
+/**
+ * @brief Kind of entry recorded in the link history.
+ */
+typedef enum {
+    WIFI_MANAGER_LINK_CONNECTED,     ///< Station got an IP address
+    WIFI_MANAGER_LINK_DISCONNECTED,  ///< Station lost the AP (see reason)
+    WIFI_MANAGER_LINK_RSSI_SAMPLE,   ///< Periodic RSSI sample while connected
+} wifi_manager_link_event_type_t;
+
+/**
+ * @brief One entry of the link history ring buffer.
+ */
+typedef struct {
+    int64_t timestamp_us;                 ///< esp_timer time of the event
+    wifi_manager_link_event_type_t type;  ///< Event kind
+    uint16_t reason;                      ///< wifi_err_reason_t for disconnects, 0 otherwise
+    int8_t rssi;                          ///< Signal strength in dBm (0 if unknown)
+    uint32_t reconnect_ms;                ///< Time to reconnect, for CONNECTED events
+} wifi_manager_link_event_t;
+
+/**
+ * @brief Connection quality statistics of the station interface.
+ *
+ * `history` holds the last `history_len` link events, oldest first.
+ */
+typedef struct {
+    bool connected;               ///< True while the station holds an IP
+    uint32_t disconnect_count;    ///< Link losses since boot
+    uint32_t reconnect_attempts;  ///< Failed attempts in the current outage
+    int64_t next_retry_at_us;     ///< esp_timer time of the next scheduled retry (0 = none)
+    uint16_t last_reason;         ///< Last disconnect reason code
+    int8_t last_rssi;             ///< Most recent RSSI in dBm
+    uint32_t reconnect_count;     ///< Successful reconnections after an outage
+    uint32_t last_reconnect_ms;   ///< Duration of the last outage
+    uint32_t max_reconnect_ms;    ///< Longest outage observed
+    uint64_t total_reconnect_ms;  ///< Sum of all outages (for averaging)
+    size_t history_len;
+    wifi_manager_link_event_t history[WIFI_MANAGER_HISTORY_LEN];
+} wifi_manager_stats_t;
+
 /**
  * @brief Initialize Wi-Fi and select operation mode.
  *
  * If valid Wi-Fi credentials are stored, the ESP32 attempts to connect to the AP.
- * If `force_config` is true or connection fails, the device switches to configuration mode:
- * An internal Access Point is created to allow the user to enter new credentials.
+ * If `force_config` is true or no credentials are stored, the device also enters
+ * configuration mode: an internal Access Point and the HTTP portal are started to
+ * allow the user to enter new credentials. Stored credentials keep being used by
+ * the station in parallel (AP+STA), so normal operation continues.
+ *
+ * This function does not block.
  *
  * @param force_config  If true, AP configuration mode is forced regardless of saved credentials.
  */
 void wifi_manager_init(bool force_config);
 
+/**
+ * @brief Switch the station to new credentials without rebooting.
+ *
+ * Adds the station interface if only the configuration AP was running. In
+ * configuration mode, the AP and the portal are stopped a few seconds after
+ * the new credentials got an IP address.
+ *
+ * @param ssid  Network name.
+ * @param pass  Network password.
+ *
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG for an empty SSID.
+ *  - ESP_ERR_INVALID_STATE if wifi_manager_init() was not called.
+ *  - Other esp_err_t codes from the Wi-Fi driver.
+ */
+esp_err_t wifi_manager_apply_credentials(const char *ssid, const char *pass);
+
+/**
+ * @brief Check whether the configuration AP and portal are running.
+ *
+ * @return true in configuration mode.
+ */
+bool wifi_manager_is_config_mode(void);
+
+/**
+ * @brief Block until the station gets an IP address or the timeout expires.
+ *
+ * @param timeout_ms Maximum wait in milliseconds.
+ *
+ * @return true if connected, false on timeout.
+ */
+bool wifi_manager_wait_connected(uint32_t timeout_ms);
+
+/**
+ * @brief Check whether the station currently holds an IP address.
+ *
+ * Network users (e.g. the weather fetch loop) can skip attempts that are
+ * known to fail while the link is down.
+ *
+ * @return true if connected, false otherwise.
+ */
+bool wifi_manager_is_connected(void);
+
+/**
+ * @brief Time until the next scheduled reconnect attempt.
+ *
+ * @return Milliseconds until the backoff timer fires, or 0 if no retry is pending.
+ */
+uint32_t wifi_manager_next_retry_ms(void);
+
+/**
+ * @brief Record the current RSSI of the associated AP in the link history.
+ *
+ * Does nothing if the station is not associated.
+ */
+void wifi_manager_sample_rssi(void);
+
+/**
+ * @brief Take a consistent snapshot of the connection statistics.
+ *
+ * @param[out] out Structure to fill.
+ */
+void wifi_manager_get_stats(wifi_manager_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
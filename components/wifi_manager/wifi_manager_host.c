@@ -0,0 +1,80 @@
+/*
+ * Host (linux target) stand-in for wifi_manager.c: the workstation network
+ * is always up, so the station reports connected with a fixed RSSI. There is
+ * no configuration AP; config mode only exposes the portal pages on the
+ * workstation's HTTP server.
+ */
+#include <string.h>
+#include "wifi_manager.h"
+#include "http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "WIFI_MANAGER";
+
+#define HOST_RSSI_DBM (-50)
+
+static bool config_mode = false;
+
+void wifi_manager_init(bool force_config)
+{
+    if (force_config) {
+        ESP_LOGW(TAG, "Host build: config mode, portal pages served without an AP");
+        config_mode = true;
+        http_server_set_portal(true);
+    }
+    ESP_LOGI(TAG, "Host build: using the workstation network");
+}
+
+esp_err_t wifi_manager_apply_credentials(const char *ssid, const char *pass)
+{
+    if (!ssid || !pass || strlen(ssid) == 0)
+        return ESP_ERR_INVALID_ARG;
+
+    /* Same outcome as a successful connect on the board: config mode ends */
+    ESP_LOGI(TAG, "Host build: ignoring credentials for '%s'", ssid);
+    if (config_mode) {
+        config_mode = false;
+        http_server_set_portal(false);
+    }
+    return ESP_OK;
+}
+
+bool wifi_manager_is_config_mode(void)
+{
+    return config_mode;
+}
+
+bool wifi_manager_wait_connected(uint32_t timeout_ms)
+{
+    return true;
+}
+
+bool wifi_manager_is_connected(void)
+{
+    return true;
+}
+
+uint32_t wifi_manager_next_retry_ms(void)
+{
+    return 0;
+}
+
+void wifi_manager_sample_rssi(void)
+{
+}
+
+void wifi_manager_get_stats(wifi_manager_stats_t *out)
+{
+    if (!out)
+        return;
+    memset(out, 0, sizeof(*out));
+    out->connected = true;
+    out->last_rssi = HOST_RSSI_DBM;
+    out->history_len = 1;
+    out->history[0] = (wifi_manager_link_event_t) {
+        .timestamp_us = esp_timer_get_time(),
+        .type = WIFI_MANAGER_LINK_CONNECTED,
+        .rssi = HOST_RSSI_DBM,
+    };
+}
@@ -8,21 +8,206 @@
  */
 
 #include <stdio.h>
+#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "wifi_manager.h"
 #include "weather_handler.h"
 #include "display_manager.h"
 #include "display_assets.h"
 #include "gpio_handler.h"
-#include "nvs_manager.h"
+#include "config_manager.h"
+#include "power_manager.h"
+#include "history_log.h"
+#include "http_server.h"
+#include "metrics.h"
+#include "boot_timeline.h"
+#include "trace_recorder.h"
+#include "heap_monitor.h"
+#include "json_arena.h"
+#include "fw_info.h"
 
-#define DEFAULT_LATITUDE -30.0133836
-#define DEFAULT_LONGITUDE -51.1459955
+/* Weather refresh period, and retry period after a failed cycle in deep sleep mode */
+#define FETCH_INTERVAL_MS 600000
+#define FETCH_RETRY_INTERVAL_MS 60000
+
+/* Maximum wait for the station to get an IP at boot */
+#define WIFI_CONNECT_TIMEOUT_MS 10000
+
+/* Extra wait after a scheduled reconnect before checking the link again */
+#define WIFI_WAIT_MARGIN_MS 5000
 
 static const char *TAG = "MAIN";
 
+/* Scheduler state, retained in RTC memory across deep sleep cycles */
+#define SCHED_MAGIC 0x57534331  // "WSC1"
+
+typedef struct {
+    uint32_t magic;
+    bool weather_valid;
+    weather_data_t weather;  ///< Last successfully fetched data
+    uint32_t fetch_ok;
+    uint32_t fetch_fail;
+    uint32_t consecutive_failures;
+} scheduler_state_t;
+
+static RTC_DATA_ATTR scheduler_state_t sched;
+
+static TaskHandle_t main_task = NULL;
+
+/**
+ * @brief Config change subscriber: wake the fetch loop so new settings
+ *        (location, or Wi-Fi applied by wifi_manager) are used right away.
+ */
+static void on_config_changed(const app_config_t *cfg, uint32_t changed, void *ctx)
+{
+    if (main_task)
+        xTaskNotifyGive(main_task);
+}
+
+/**
+ * @brief Wait for the given time or until new settings are applied.
+ */
+static void wait_next_cycle(uint32_t wait_ms)
+{
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+}
+
+/**
+ * @brief Draw the weather screen (icon, temperature, humidity).
+ */
+static void render_weather(const weather_data_t *weather)
+{
+    char line[32];
+    trace_begin("render");
+    display_clear();
+
+    // Display Weather Icon
+    if (strcmp(weather_data_wmo_description(weather->weather_code), "Clear") == 0) {
+        display_draw_icon(0, 4, 24, 24, (weather->is_day ? icon_sun : icon_moon));
+    } else if (strcmp(weather_data_wmo_description(weather->weather_code), "Cloudy") == 0) {
+        display_draw_icon(0, 4, 24, 24, icon_cloud);
+    } else if (strcmp(weather_data_wmo_description(weather->weather_code), "Rain") == 0) {
+        display_draw_icon(0, 4, 24, 24, icon_rain);
+    } else {
+        display_draw_text_6x8(0, 12, "???");
+    }
+
+    snprintf(line, sizeof(line), "T:%.1fC", weather->temperature);
+    display_draw_text_12x16(33, 0, line);
+    snprintf(line, sizeof(line), "H:%.0f%%", weather->humidity);
+    display_draw_text_6x8(33, 20, line);
+    display_refresh();
+    trace_end("render");
+}
+
+/**
+ * @brief Store one fetched sample in the on-flash history log.
+ */
+static void record_history(const weather_data_t *weather)
+{
+    if (weather->timestamp == 0)
+        return;
+
+    history_record_t rec = {
+        .timestamp = weather->timestamp,
+        .temperature_x100 = (int16_t)lroundf(weather->temperature * 100.0f),
+        .humidity_x100 = (uint16_t)lroundf(weather->humidity * 100.0f),
+        .precipitation_x100 = (uint16_t)lroundf(weather->precipitation * 100.0f),
+        .weather_code = (uint8_t)weather->weather_code,
+        .flags = weather->is_day ? HISTORY_FLAG_IS_DAY : 0,
+    };
+    esp_err_t err = history_log_append(&rec);
+    if (err != ESP_OK)
+        ESP_LOGW(TAG, "History append failed: %s", esp_err_to_name(err));
+}
+
+/**
+ * @brief Push the new sample to /api/events subscribers (no-op without subscribers).
+ */
+static void push_weather_event(const weather_data_t *weather, uint32_t fetch_ms)
+{
+    char json[192];
+    snprintf(json, sizeof(json),
+             "{\"temperature\":%.1f,\"humidity\":%.0f,\"precipitation\":%.2f,"
+             "\"weather_code\":%d,\"is_day\":%s,\"timestamp\":%u,\"fetch_ms\":%u}",
+             weather->temperature, weather->humidity, weather->precipitation,
+             weather->weather_code, weather->is_day ? "true" : "false",
+             (unsigned)weather->timestamp, (unsigned)fetch_ms);
+    http_server_push_event(HTTP_SERVER_EVENT_WEATHER, json);
+}
+
+/**
+ * @brief Fetch one weather sample, render it and update the scheduler state.
+ *
+ * @return true on success.
+ */
+static bool fetch_and_render(void)
+{
+    weather_data_t weather;
+
+    /* Location comes from the RAM config cache, no flash access */
+    app_config_t cfg;
+    config_manager_get(&cfg);
+    double latitude = cfg.latitude;
+    double longitude = cfg.longitude;
+
+    wifi_manager_sample_rssi();
+    ESP_LOGI(TAG, "📡 Fetching weather data...");
+
+    // Get open-meteo data
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = weather_data_fetch((float)latitude, (float)longitude, &weather);
+    uint32_t fetch_us = (uint32_t)(esp_timer_get_time() - start_us);
+    metrics_inc(METRIC_WEATHER_FETCH_TOTAL);
+    metrics_observe_us(METRIC_WEATHER_FETCH_LATENCY, fetch_us);
+
+    if (err == ESP_OK) {
+        uint32_t fetch_ms = fetch_us / 1000;
+        ESP_LOGI(TAG,
+                 "🌡️ Temp: %.1f°C | 💧 Humidity: %.0f%% | Precipitation %.2fmm | %s | %s",
+                 weather.temperature, weather.humidity, weather.precipitation,
+                 weather_data_wmo_description(weather.weather_code),
+                 weather.is_day ? "Day" : "Night");
+
+        render_weather(&weather);
+        power_manager_mark_display_ready();
+        record_history(&weather);
+        push_weather_event(&weather, fetch_ms);
+
+        sched.weather = weather;
+        sched.weather_valid = true;
+        sched.fetch_ok++;
+        sched.consecutive_failures = 0;
+        return true;
+    }
+
+    ESP_LOGE(TAG, "❌ Failed to fetch weather data");
+    metrics_inc(METRIC_WEATHER_FETCH_FAILED);
+    display_clear();
+    display_draw_text_6x8(0, 0, "Weather fetch fail");
+    display_refresh();
+
+    sched.fetch_fail++;
+    sched.consecutive_failures++;
+    return false;
+}
+
+/**
+ * @brief Sleep until the next scheduled fetch, keeping a fixed cycle period.
+ *
+ * The time already spent awake in this cycle is subtracted from the period.
+ */
+static void deep_sleep_until_next_cycle(uint32_t period_ms)
+{
+    uint32_t awake_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    uint32_t sleep_ms = (period_ms > awake_ms) ? period_ms - awake_ms : 1000;
+    power_manager_deep_sleep(sleep_ms);
+}
+
 /**
  * @brief Main application logic (FreeRTOS entry point).
  *
@@ -35,84 +220,124 @@ static const char *TAG = "MAIN";
  *  - Decode weather response and update OLED rendering.
  *
  * The task runs indefinitely, polling weather data every 10 minutes.
+ * With CONFIG_POWER_DEEP_SLEEP_MODE the chip instead sleeps between fetches
+ * and redraws the RTC-retained weather right after each wake-up.
  */
 void app_main(void)
 {
+    boot_timeline_mark("app_main");
     ESP_LOGI(TAG, "==== ESP32 Weather Display v2 ====");
 
+    bool resumed = power_manager_woke_from_sleep() && sched.magic == SCHED_MAGIC;
+    if (!resumed) {
+        sched = (scheduler_state_t) { .magic = SCHED_MAGIC };
+    }
+
+    main_task = xTaskGetCurrentTaskHandle();
+
+    // Per-module heap accounting, and cJSON hooks (arenas) before any JSON use
+    heap_monitor_init();
+    json_arena_install_hooks();
+
+    // Chip, MAC and flash size probed once, off the HTTP request path
+    fw_info_init();
+
+    // DFS + automatic light sleep; hot sections take their own locks
+    power_manager_init();
+    boot_timeline_mark("power");
+
     // GPIO Handler Initialization
     gpio_handler_init();
+    boot_timeline_mark("gpio");
+
+    if (resumed && sched.weather_valid) {
+        /* Put the retained data back on screen before touching Wi-Fi */
+        display_resume();
+        render_weather(&sched.weather);
+        power_manager_mark_display_ready();
+    } else {
+        /* Display Initialization */
+        display_init();
+
+        // Show Icon and Text of WiFi Connecting
+        display_show_wifi_connecting();
+    }
+    boot_timeline_mark("display");
 
-    /* Display Initialization */
-    display_init();
+    // Load the configuration once; portal changes are applied live, without a reboot
+    config_manager_init();
+    config_manager_subscribe(on_config_changed, NULL);
+    boot_timeline_mark("config");
 
-    // Show Icon and Text of WiFi Connecting
-    display_show_wifi_connecting();
+    // Weather history ring on its own partition; the display works without it
+    if (history_log_init() != ESP_OK)
+        ESP_LOGW(TAG, "History log unavailable");
+    boot_timeline_mark("history");
 
     // Start the WiFi Connection, check if button pressed if yes, enter in config mode
+    // (non-blocking: the portal runs next to normal operation)
     wifi_manager_init(gpio_handler_is_config_button_pressed());
+    boot_timeline_mark("wifi_init");
 
-    // Wait WiFi Connection before follow the next step
-    vTaskDelay(pdMS_TO_TICKS(10000));
-
-    // Show Icon and Text of WiFi Connected
-    display_show_wifi_connected();
+    // Status, metrics and diagnostics API on every interface; the portal pages only in config mode
+    if (http_server_start() != ESP_OK)
+        ESP_LOGW(TAG, "HTTP server unavailable");
+    boot_timeline_mark("http");
 
-    // Initialize the nvs_manager
-    nvs_manager_init();
+    // Wait WiFi Connection before follow the next step
+    bool connected = wifi_manager_wait_connected(WIFI_CONNECT_TIMEOUT_MS);
+    boot_timeline_mark(connected ? "wifi_ip" : "wifi_timeout");
 
-    /* Get saved lat long from NVS */
-    double latitude = 0.0, longitude = 0.0;
-    if (nvs_manager_read_double("latitude", &latitude) != ESP_OK) {
-        latitude = DEFAULT_LATITUDE;
+    if (!resumed && connected) {
+        // Show Icon and Text of WiFi Connected
+        display_show_wifi_connected();
     }
 
-    if (nvs_manager_read_double("longitude", &longitude) != ESP_OK) {
-        longitude = DEFAULT_LONGITUDE;
+    /* The portal needs the device awake, so no duty cycling in config mode */
+    if (power_manager_deep_sleep_enabled() && !wifi_manager_is_config_mode()) {
+        /* One fetch per wake-up, then sleep; a failed cycle is retried sooner */
+        bool ok = connected && fetch_and_render();
+        boot_timeline_mark("first_fetch");
+        boot_timeline_dump();
+        if (!connected) {
+            ESP_LOGW(TAG, "Wi-Fi not connected, skipping this cycle");
+            sched.consecutive_failures++;
+        }
+        deep_sleep_until_next_cycle(ok ? FETCH_INTERVAL_MS : FETCH_RETRY_INTERVAL_MS);
     }
 
-    // Struct to store weather data
-    weather_data_t weather;
-
+    bool boot_reported = false;
     while (true) {
-        ESP_LOGI(TAG, "📡 Fetching weather data...");
-
-        // Get open-meteo data
-        if (weather_data_fetch((float)latitude, (float)longitude, &weather) == ESP_OK) {
-            ESP_LOGI(
-                TAG,
-                "🌡️ Temp: %.1f°C | 💧 Humidity: %.0f%% | Precipitation %.2fmm | %s | %s",
-                weather.temperature, weather.humidity, weather.precipitation,
-                weather_data_wmo_description(weather.weather_code),
-                weather.is_day ? "Day" : "Night");
-
-            char line[32];
+        // Skip the fetch while the link is down, it would only time out
+        if (!wifi_manager_is_connected()) {
+            uint32_t retry_ms = wifi_manager_next_retry_ms();
+            ESP_LOGW(TAG, "Wi-Fi down, skipping fetch (next reconnect in %u ms)",
+                     (unsigned)retry_ms);
             display_clear();
-
-            // Display Weather Icon
-            if (strcmp(weather_data_wmo_description(weather.weather_code), "Clear") == 0) {
-                display_draw_icon(0, 4, 24, 24, (weather.is_day ? icon_sun : icon_moon));
-            } else if (strcmp(weather_data_wmo_description(weather.weather_code), "Cloudy") == 0) {
-                display_draw_icon(0, 4, 24, 24, icon_cloud);
-            } else if (strcmp(weather_data_wmo_description(weather.weather_code), "Rain") == 0) {
-                display_draw_icon(0, 4, 24, 24, icon_rain);
+            if (wifi_manager_is_config_mode()) {
+                display_draw_text_6x8(0, 0, "Config mode");
+                display_draw_text_6x8(0, 12, "AP: ESP_Config");
             } else {
-                display_draw_text_6x8(0, 12, "???");
+                display_draw_text_6x8(0, 0, "WiFi offline");
             }
-
-            snprintf(line, sizeof(line), "T:%.1fC", weather.temperature);
-            display_draw_text_12x16(33, 0, line);
-            snprintf(line, sizeof(line), "H:%.0f%%", weather.humidity);
-            display_draw_text_6x8(33, 20, line);
-            display_refresh();
-        } else {
-            ESP_LOGE(TAG, "❌ Failed to fetch weather data");
-            display_clear();
-            display_draw_text_6x8(0, 0, "Weather fetch fail");
             display_refresh();
+            wait_next_cycle(retry_ms + WIFI_WAIT_MARGIN_MS);
+            continue;
+        }
+
+        bool ok = fetch_and_render();
+        if (!boot_reported) {
+            boot_timeline_mark("first_fetch");
+            boot_timeline_dump();
+            boot_reported = true;
         }
+        power_manager_dump_residency();
+
+        /* Config mode ended (new credentials connected): back to duty cycling */
+        if (power_manager_deep_sleep_enabled() && !wifi_manager_is_config_mode())
+            deep_sleep_until_next_cycle(ok ? FETCH_INTERVAL_MS : FETCH_RETRY_INTERVAL_MS);
 
-        // Update every 10 minutes
-        vTaskDelay(pdMS_TO_TICKS(600000));
+        // Update every 10 minutes, or right away after a config change
+        wait_next_cycle(FETCH_INTERVAL_MS);
     }
 }
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Open-Meteo stand-in with fault injection, for the linux (host) build.
+
+Serves the recorded reply in tools/fixtures/ at /v1/forecast over plain HTTP,
+with the requested coordinates and a current timestamp patched in. Point the
+host build at it with CONFIG_WEATHER_API_BASE_URL (the linux default is
+http://127.0.0.1:8080).
+
+A fault can be chosen at start-up (--fault) or switched at runtime, optionally
+for the next N requests only, which is how retries are exercised:
+
+    python3 tools/mock_open_meteo.py --fault latency --delay 3
+    curl 'http://127.0.0.1:8080/_fault?mode=503&count=2'   # two 503s, then OK
+
+Faults:
+    ok             recorded reply
+    latency        reply after --delay seconds
+    partial        body in 16-byte pieces, 50 ms apart
+    trickle        one body byte per second (slow loris)
+    truncated      Content-Length of the full body, half of it sent, then close
+    oversized      64 KiB body with Content-Length
+    oversized_raw  64 KiB body without Content-Length, ended by close
+    invalid_json   body that is not JSON
+    missing_field  'current' without temperature_2m
+    429            Too Many Requests with Retry-After: 1
+    500, 503       server errors
+"""
+
+import argparse
+import json
+import os
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+FIXTURE = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'fixtures',
+                       'forecast_current.json')
+
+FAULTS = ('ok', 'latency', 'partial', 'trickle', 'truncated', 'oversized', 'oversized_raw',
+          'invalid_json', 'missing_field', '429', '500', '503')
+
+OVERSIZED_BYTES = 64 * 1024
+
+
+class FaultState:
+    """Active fault, shared by the handler threads."""
+
+    def __init__(self, mode, delay):
+        self.lock = threading.Lock()
+        self.default = mode
+        self.mode = mode
+        self.remaining = 0  # Requests left before falling back to default, 0 = no limit
+        self.delay = delay
+
+    def set(self, mode, count):
+        with self.lock:
+            if count > 0:
+                self.mode, self.remaining = mode, count
+            else:
+                self.default = self.mode = mode
+                self.remaining = 0
+
+    def take(self):
+        with self.lock:
+            mode = self.mode
+            if self.remaining > 0:
+                self.remaining -= 1
+                if self.remaining == 0:
+                    self.mode = self.default
+            return mode
+
+
+def load_fixture(path, query):
+    with open(path, encoding='utf-8') as f:
+        reply = json.load(f)
+    reply['latitude'] = float(query.get('latitude', [reply['latitude']])[0])
+    reply['longitude'] = float(query.get('longitude', [reply['longitude']])[0])
+    reply['current']['time'] = int(time.time()) // 900 * 900
+    return reply
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    state = None
+    fixture = FIXTURE
+
+    def do_GET(self):
+        url = urlparse(self.path)
+        query = parse_qs(url.query)
+        if url.path == '/_fault':
+            self.set_fault(query)
+        elif url.path == '/v1/forecast':
+            self.forecast(query, self.state.take())
+        else:
+            self.send_error(404)
+
+    def set_fault(self, query):
+        mode = query.get('mode', ['ok'])[0]
+        if mode not in FAULTS:
+            self.send_error(400, f'unknown fault, one of: {", ".join(FAULTS)}')
+            return
+        self.state.set(mode, int(query.get('count', ['0'])[0]))
+        self.reply(200, f'fault {mode}\n'.encode(), 'text/plain')
+
+    def forecast(self, query, mode):
+        self.log_message('fault: %s', mode)
+        reply = load_fixture(self.fixture, query)
+
+        if mode in ('429', '500', '503'):
+            body = json.dumps({'error': True, 'reason': f'mock {mode}'}).encode()
+            headers = {'Retry-After': '1'} if mode == '429' else {}
+            self.reply(int(mode), body, headers=headers)
+            return
+        if mode == 'invalid_json':
+            self.reply(200, b'<html>upstream error</html>')
+            return
+        if mode == 'missing_field':
+            del reply['current']['temperature_2m']
+        if mode in ('oversized', 'oversized_raw'):
+            reply['padding'] = 'x' * OVERSIZED_BYTES
+
+        body = json.dumps(reply, ensure_ascii=False).encode()
+        if mode == 'latency':
+            time.sleep(self.state.delay)
+        if mode == 'partial':
+            self.reply(200, body, pieces=16, gap_s=0.05)
+        elif mode == 'trickle':
+            self.reply(200, body, pieces=1, gap_s=1.0)
+        elif mode == 'truncated':
+            self.reply(200, body, send_bytes=len(body) // 2)
+        elif mode == 'oversized_raw':
+            self.reply(200, body, content_length=False)
+        else:
+            self.reply(200, body)
+
+    def reply(self, status, body, content_type='application/json', headers=None,
+              pieces=0, gap_s=0.0, send_bytes=None, content_length=True):
+        self.send_response(status)
+        self.send_header('Content-Type', content_type)
+        if content_length:
+            self.send_header('Content-Length', str(len(body)))
+        self.send_header('Connection', 'close')
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+        self.close_connection = True
+
+        data = body if send_bytes is None else body[:send_bytes]
+        try:
+            if pieces:
+                for i in range(0, len(data), pieces):
+                    self.wfile.write(data[i:i + pieces])
+                    self.wfile.flush()
+                    time.sleep(gap_s)
+            else:
+                self.wfile.write(data)
+        except (BrokenPipeError, ConnectionResetError):
+            self.log_message('client went away')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--fault', choices=FAULTS, default='ok')
+    parser.add_argument('--delay', type=float, default=3.0, help='seconds, for the latency fault')
+    parser.add_argument('--fixture', default=FIXTURE, help='recorded reply to serve')
+    args = parser.parse_args()
+
+    Handler.state = FaultState(args.fault, args.delay)
+    Handler.fixture = args.fixture
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    print(f'Mock Open-Meteo on http://{args.host}:{args.port}/v1/forecast (fault: {args.fault})')
+    server.serve_forever()
+
+
+if __name__ == '__main__':
+    main()